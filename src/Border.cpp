@@ -0,0 +1,64 @@
+#include "Border.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+int borderIndex(int i, int n, BorderMode mode) {
+    if (i >= 0 && i < n)
+        return i;
+    switch (mode) {
+        case BorderMode::Clamp:
+            return i < 0 ? 0 : n - 1;
+        case BorderMode::Reflect: {
+            if (n == 1)
+                return 0;
+            const int period = 2 * n - 2;
+            i %= period;
+            if (i < 0)
+                i += period;
+            return i < n ? i : period - i;
+        }
+        case BorderMode::Wrap:
+            i %= n;
+            return i < 0 ? i + n : i;
+        default: // BorderMode::Constant
+            return -1;
+    }
+}
+
+void copyWithBorder(const unsigned char* src, int w, int h, int c, int x0, int x1, int y0, int y1,
+                    const Border& border, unsigned char* dst, size_t dstStride) {
+    // Interior columns are one contiguous copy per row; only the halo
+    // columns go through the index map, which is built once for the band
+    const int inner0 = std::min(std::max(x0, 0), x1);
+    const int inner1 = std::max(std::min(x1, w), inner0);
+    std::vector<int> halo;
+    for (int x = x0; x < x1; ++x)
+        if (x < inner0 || x >= inner1)
+            halo.push_back(borderIndex(x, w, border.mode));
+
+    const size_t rowBytes = static_cast<size_t>(x1 - x0) * c;
+    for (int y = y0; y < y1; ++y) {
+        unsigned char* out = dst + (y - y0) * dstStride;
+        const int sy = borderIndex(y, h, border.mode);
+        if (sy < 0) {
+            std::memset(out, border.value, rowBytes);
+            continue;
+        }
+        const unsigned char* row = src + static_cast<size_t>(sy) * w * c;
+        size_t k = 0;
+        auto copyHalo = [&](int from, int to) {
+            for (int x = from; x < to; ++x, ++k) {
+                unsigned char* px = out + static_cast<size_t>(x - x0) * c;
+                if (halo[k] < 0)
+                    std::memset(px, border.value, c);
+                else
+                    std::memcpy(px, row + static_cast<size_t>(halo[k]) * c, c);
+            }
+        };
+        copyHalo(x0, inner0);
+        std::memcpy(out + static_cast<size_t>(inner0 - x0) * c, row + static_cast<size_t>(inner0) * c,
+                    static_cast<size_t>(inner1 - inner0) * c);
+        copyHalo(inner1, x1);
+    }
+}
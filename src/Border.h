@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+
+// How filters read pixels outside the image, for an image "abcdefgh":
+//   Clamp     aaaa|abcdefgh|hhhh   repeat the edge pixel
+//   Reflect   edcb|abcdefgh|gfed   mirror about the edge pixel
+//   Wrap      efgh|abcdefgh|abcd   periodic
+//   Constant  vvvv|abcdefgh|vvvv   a fixed value v
+enum class BorderMode { Clamp, Reflect, Wrap, Constant };
+
+struct Border {
+    BorderMode mode;
+    unsigned char value; // only used by BorderMode::Constant
+
+    Border(BorderMode _mode = BorderMode::Clamp, unsigned char _value = 0) : mode(_mode), value(_value) {}
+};
+
+// Maps coordinate i onto [0, n), or returns -1 for a Constant border
+int borderIndex(int i, int n, BorderMode mode);
+
+// Copies columns [x0, x1) of rows [y0, y1) of an interleaved w x h image with
+// c channels into dst (row stride dstStride bytes), resolving coordinates
+// outside the image with the border. Filters pad a band or tile once with
+// this, so their inner loops need no bounds checks or border branches.
+void copyWithBorder(const unsigned char* src, int w, int h, int c, int x0, int x1, int y0, int y1,
+                    const Border& border, unsigned char* dst, size_t dstStride);
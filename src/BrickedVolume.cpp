@@ -0,0 +1,319 @@
+#include "BrickedVolume.h"
+#include "Volume.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+// Brick file header: magic, then width, height, depth and whether the bricks
+// still mirror the slices (1) or have been written to (0), as int32
+const char Magic[4] = {'B', 'R', 'K', '2'};
+
+} // namespace
+
+BrickedVolume::BrickedVolume(const std::string& directory, const std::string& brickFile, size_t cacheBytes)
+    : w(0), h(0), d(0), bricksX(0), bricksY(0), bricksZ(0), capacity(std::max<size_t>(1, cacheBytes / BrickBytes)),
+      ready(false), pristine(false), path(brickFile), ioFailed(false) {
+    const std::vector<std::string> files = Volume::listSlices(directory);
+    if (files.empty()) {
+        std::cerr << "No slice images in " << directory << std::endl;
+        return;
+    }
+    int channels;
+    if (!stbi_info(files[0].c_str(), &w, &h, &channels)) {
+        std::cerr << "Cannot read " << files[0] << std::endl;
+        return;
+    }
+    d = static_cast<int>(files.size());
+    bricksX = (w + BrickSize - 1) / BrickSize;
+    bricksY = (h + BrickSize - 1) / BrickSize;
+    bricksZ = (d + BrickSize - 1) / BrickSize;
+
+    // An existing brick file is reused if no slice has changed since
+    std::error_code error;
+    const auto built = std::filesystem::last_write_time(brickFile, error);
+    bool current = !error;
+    for (size_t i = 0; current && i < files.size(); ++i)
+        current = std::filesystem::last_write_time(files[i], error) <= built && !error;
+    if (!(current && open(brickFile)) && !(build(files, brickFile) && open(brickFile))) {
+        std::cerr << "Failed to brick volume " << directory << " into " << brickFile << std::endl;
+        return;
+    }
+    ready = true;
+}
+
+BrickedVolume::~BrickedVolume() {
+    if (pending.valid())
+        pending.wait();
+}
+
+bool BrickedVolume::build(const std::vector<std::string>& files, const std::string& brickFile) {
+    // The header marks the file as unfinished until every slice is in
+    int32_t header[5];
+    std::memcpy(header, Magic, sizeof(Magic));
+    header[1] = w;
+    header[2] = h;
+    header[3] = d;
+    header[4] = 0;
+    {
+        std::ofstream out(brickFile, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(header), HeaderBytes);
+        if (!out) {
+            std::cerr << "Cannot write " << brickFile << std::endl;
+            return false;
+        }
+    }
+    // Sized up front, so the padding of edge bricks is already zero
+    std::error_code error;
+    std::filesystem::resize_file(brickFile, offset(bricksX * bricksY * bricksZ), error);
+    if (!error)
+        file.open(brickFile, std::ios::binary | std::ios::in | std::ios::out);
+    if (error || !file) {
+        std::cerr << "Cannot write " << brickFile << std::endl;
+        file.close();
+        file.clear();
+        return false;
+    }
+
+    // Slices decode in parallel and go straight to their bricks, so only one
+    // decoded slice per thread is held, whatever the cache size
+    bool failed = false;
+    #pragma omp parallel for schedule(dynamic) reduction(|| : failed)
+    for (int z = 0; z < d; ++z) {
+        const Volume::SlicePixels pixels = Volume::loadSlice(files[z], w, h);
+        if (pixels)
+            storeSlice(z, pixels.get());
+        else
+            failed = true;
+    }
+    failed = failed || ioFailed || !markPristine(true);
+    file.close();
+    file.clear();
+    return !failed;
+}
+
+bool BrickedVolume::open(const std::string& brickFile) {
+    file.open(brickFile, std::ios::binary | std::ios::in | std::ios::out);
+    int32_t header[5];
+    const size_t bricks = static_cast<size_t>(bricksX) * bricksY * bricksZ;
+    if (file.read(reinterpret_cast<char*>(header), HeaderBytes) && std::memcmp(header, Magic, sizeof(Magic)) == 0 &&
+        header[1] == w && header[2] == h && header[3] == d && header[4] == 1 && file.seekg(0, std::ios::end) &&
+        static_cast<size_t>(file.tellg()) == offset(static_cast<int>(bricks))) {
+        pristine = true;
+        return true;
+    }
+    file.close();
+    file.clear();
+    return false;
+}
+
+bool BrickedVolume::markPristine(bool value) {
+    const int32_t state = value;
+    std::lock_guard<std::mutex> lock(fileMutex);
+    file.seekp(4 * sizeof(int32_t));
+    if (!file.write(reinterpret_cast<const char*>(&state), sizeof(state)).flush()) {
+        ioFailure("write the header");
+        return false;
+    }
+    pristine = value;
+    return true;
+}
+
+void BrickedVolume::ioFailure(const std::string& what) const {
+    if (!ioFailed.exchange(true))
+        std::cerr << "Cannot " << what << " of " << path << std::endl;
+    file.clear();
+}
+
+BrickedVolume::Brick BrickedVolume::cached(int id) const {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto found = cache.find(id);
+    if (found == cache.end())
+        return nullptr;
+    recent.splice(recent.begin(), recent, found->second.second);
+    return found->second.first;
+}
+
+BrickedVolume::Brick BrickedVolume::brick(int bx, int by, int bz) const {
+    const int id = (bz * bricksY + by) * bricksX + bx;
+    if (Brick hit = cached(id))
+        return hit;
+
+    // Readers holding the cache lock are not blocked by the file read. The
+    // brick is cached before the file lock is released, so a concurrent
+    // writeSlice either lands in the file before the read or finds the brick
+    // in the cache. If another thread loaded the brick meanwhile, its copy
+    // wins.
+    Brick loaded = std::make_shared<std::vector<unsigned char>>(BrickBytes);
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    if (ioFailed || !file.seekg(offset(id)).read(reinterpret_cast<char*>(loaded->data()), BrickBytes)) {
+        // Zeros, left out of the cache so a later read tries again
+        ioFailure("read brick " + std::to_string(id));
+        std::fill(loaded->begin(), loaded->end(), 0);
+        return loaded;
+    }
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto found = cache.find(id);
+    if (found != cache.end())
+        return found->second.first;
+    recent.push_front(id);
+    cache.emplace(id, std::make_pair(loaded, recent.begin()));
+    while (cache.size() > capacity) {
+        cache.erase(recent.back());
+        recent.pop_back();
+    }
+    return loaded;
+}
+
+void BrickedVolume::readSlice(int z, unsigned char* out) const {
+    const int bz = z / BrickSize;
+    const size_t plane = static_cast<size_t>(z % BrickSize) * BrickSize * BrickSize;
+    const bool wholeBricks = capacity >= static_cast<size_t>(bricksX) * bricksY;
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int b = 0; b < bricksX * bricksY; ++b) {
+        const int bx = b % bricksX;
+        const int by = b / bricksX;
+        const int id = (bz * bricksY + by) * bricksX + bx;
+        Brick source = cached(id);
+        if (!source && wholeBricks)
+            source = brick(bx, by, bz);
+
+        std::vector<unsigned char> part;
+        const unsigned char* src;
+        if (source) {
+            src = source->data() + plane;
+        } else {
+            part.resize(static_cast<size_t>(BrickSize) * BrickSize);
+            std::lock_guard<std::mutex> lock(fileMutex);
+            if (ioFailed || !file.seekg(offset(id) + plane).read(reinterpret_cast<char*>(part.data()), part.size())) {
+                ioFailure("read brick " + std::to_string(id));
+                std::fill(part.begin(), part.end(), 0);
+            }
+            src = part.data();
+        }
+
+        const int x0 = bx * BrickSize;
+        const int y0 = by * BrickSize;
+        const int xn = std::min(BrickSize, w - x0);
+        const int yn = std::min(BrickSize, h - y0);
+        for (int j = 0; j < yn; ++j)
+            std::memcpy(out + static_cast<size_t>(y0 + j) * w + x0, src + j * BrickSize, xn);
+    }
+}
+
+void BrickedVolume::readBox(int x0, int y0, int z0, int x1, int y1, int z1, unsigned char* out) const {
+    if (x0 < 0 || y0 < 0 || z0 < 0 || x1 > w || y1 > h || z1 > d || x0 >= x1 || y0 >= y1 || z0 >= z1) {
+        std::cerr << "Box [" << x0 << ", " << x1 << ") x [" << y0 << ", " << y1 << ") x [" << z0 << ", " << z1
+                  << ") is outside the volume." << std::endl;
+        return;
+    }
+    const int bx0 = x0 / BrickSize, bx1 = (x1 - 1) / BrickSize;
+    const int by0 = y0 / BrickSize, by1 = (y1 - 1) / BrickSize;
+    const int bz0 = z0 / BrickSize, bz1 = (z1 - 1) / BrickSize;
+    const int nx = bx1 - bx0 + 1;
+    const int ny = by1 - by0 + 1;
+    const int nz = bz1 - bz0 + 1;
+    const size_t rowLen = x1 - x0;
+    const size_t planeLen = rowLen * (y1 - y0);
+
+    // Bricks cover disjoint parts of the box
+    #pragma omp parallel for schedule(dynamic)
+    for (int b = 0; b < nx * ny * nz; ++b) {
+        const int bx = bx0 + b % nx;
+        const int by = by0 + (b / nx) % ny;
+        const int bz = bz0 + b / (nx * ny);
+        const Brick source = brick(bx, by, bz);
+        const int xs = std::max(x0, bx * BrickSize), xe = std::min(x1, (bx + 1) * BrickSize);
+        const int ys = std::max(y0, by * BrickSize), ye = std::min(y1, (by + 1) * BrickSize);
+        const int zs = std::max(z0, bz * BrickSize), ze = std::min(z1, (bz + 1) * BrickSize);
+        for (int z = zs; z < ze; ++z)
+            for (int y = ys; y < ye; ++y)
+                std::memcpy(out + (z - z0) * planeLen + (y - y0) * rowLen + (xs - x0),
+                            source->data() + ((static_cast<size_t>(z % BrickSize) * BrickSize + y % BrickSize) *
+                                              BrickSize + xs % BrickSize),
+                            xe - xs);
+    }
+}
+
+void BrickedVolume::writeSlice(int z, const unsigned char* in) {
+    // Recorded before the first voxel changes, so an interrupted write never
+    // leaves a file that passes for the scan
+    if (pristine && !markPristine(false))
+        return;
+    storeSlice(z, in);
+}
+
+void BrickedVolume::storeSlice(int z, const unsigned char* in) {
+    const int bz = z / BrickSize;
+    const size_t plane = static_cast<size_t>(z % BrickSize) * BrickSize * BrickSize;
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int b = 0; b < bricksX * bricksY; ++b) {
+        const int bx = b % bricksX;
+        const int by = b / bricksX;
+        const int id = (bz * bricksY + by) * bricksX + bx;
+        const int x0 = bx * BrickSize;
+        const int y0 = by * BrickSize;
+        const int xn = std::min(BrickSize, w - x0);
+        const int yn = std::min(BrickSize, h - y0);
+
+        // The brick's plane, keeping the zero padding
+        std::vector<unsigned char> part(static_cast<size_t>(BrickSize) * BrickSize, 0);
+        for (int j = 0; j < yn; ++j)
+            std::memcpy(part.data() + j * BrickSize, in + static_cast<size_t>(y0 + j) * w + x0, xn);
+        std::lock_guard<std::mutex> fileLock(fileMutex);
+        file.seekp(offset(id) + plane);
+        if (ioFailed || !file.write(reinterpret_cast<const char*>(part.data()), part.size())) {
+            ioFailure("write brick " + std::to_string(id));
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto found = cache.find(id);
+        if (found != cache.end())
+            std::copy(part.begin(), part.end(), found->second.first->data() + plane);
+    }
+}
+
+void BrickedVolume::prefetch(int first, int last) const {
+    if (pending.valid())
+        pending.wait();
+    first = std::max(first, 0);
+    last = std::min(last, d - 1);
+    if (first > last)
+        return;
+
+    // Skip hints the cache could not hold next to the slab in use; they
+    // would only evict bricks about to be read
+    const int bz0 = first / BrickSize;
+    const int bz1 = last / BrickSize;
+    const size_t slab = static_cast<size_t>(bricksX) * bricksY;
+    if ((bz1 - bz0 + 2) * slab > capacity)
+        return;
+    pending = std::async(std::launch::async, [this, bz0, bz1] {
+        for (int bz = bz0; bz <= bz1; ++bz)
+            for (int by = 0; by < bricksY; ++by)
+                for (int bx = 0; bx < bricksX; ++bx)
+                    brick(bx, by, bz);
+    });
+}
+
+std::function<const unsigned char*(int)> BrickedVolume::sliceSource() const {
+    auto slice = std::make_shared<std::vector<unsigned char>>(static_cast<size_t>(w) * h);
+    auto slab = std::make_shared<int>(-1);
+    return [this, slice, slab](int z) -> const unsigned char* {
+        if (z / BrickSize != *slab) {
+            *slab = z / BrickSize;
+            prefetch((*slab + 1) * BrickSize, (*slab + 2) * BrickSize - 1);
+        }
+        readSlice(z, slice->data());
+        return slice->data();
+    };
+}
+
+void BrickedVolume::describe() const {
+    std::cout << "Bricked volume with size " << w << " x " << h << " x " << d << " in " << bricksX << " x "
+              << bricksY << " x " << bricksZ << " bricks." << std::endl;
+}
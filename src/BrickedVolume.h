@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A volume too large to hold in memory, kept as BrickSize^3 bricks in a
+// local brick file and read through an LRU cache of at most cacheBytes, so
+// the working set rather than the scan size bounds memory. Inside a brick
+// voxels are z-major like Volume; edge bricks are zero-padded to full size.
+//
+// Slices are read brick plane by brick plane: when the cache holds a whole
+// slab of bricks (one brick deep), missing bricks are loaded whole and
+// serve the next BrickSize - 1 slices from memory; otherwise only the plane
+// needed is read from the file. Planes across z (see Slice) read whole
+// bricks, a fraction of what a column of a z-major slice stack costs.
+class BrickedVolume {
+public:
+    static constexpr int BrickSize = 64;
+    static constexpr size_t BrickBytes = static_cast<size_t>(BrickSize) * BrickSize * BrickSize;
+    static constexpr size_t DefaultCacheBytes = size_t(512) << 20;
+
+    int w;
+    int h;
+    int d;
+
+    // Bricks the slice directory into brickFile, each decoded slice going
+    // straight to its plane of every brick, unless the file already holds
+    // this scan and no slice is newer than it. A brick file is only reused
+    // while it mirrors the slices: once written to through writeSlice (e.g.
+    // by an in-place 3D filter) it is rebuilt on the next construction.
+    BrickedVolume(const std::string& directory, const std::string& brickFile, size_t cacheBytes = DefaultCacheBytes);
+    ~BrickedVolume();
+
+    // False if the directory or the brick file could not be read, or once a
+    // read or write of the brick file has failed; from then on reads yield
+    // zeros and writes are dropped
+    bool good() const { return ready && !ioFailed; }
+
+    // Copies slice z (w x h) into out
+    void readSlice(int z, unsigned char* out) const;
+    // Copies the box [x0, x1) x [y0, y1) x [z0, z1) into out, x fastest
+    void readBox(int x0, int y0, int z0, int x1, int y1, int z1, unsigned char* out) const;
+    // Writes slice z through to the brick file and any cached bricks, and
+    // marks the file as modified. Slices being read concurrently must not
+    // include z.
+    void writeSlice(int z, const unsigned char* in);
+
+    // Hint that slices [first, last] are needed soon: their bricks are
+    // loaded in the background, as far as the cache holds them next to the
+    // slab in use. A new hint waits for the previous one to finish.
+    void prefetch(int first, int last) const;
+    // A slice source for Filter3D and Projection: returns slice z in a buffer
+    // of its own, valid until the next call, and hints the next slab of
+    // bricks whenever reading moves into a new one
+    std::function<const unsigned char*(int z)> sliceSource() const;
+
+    void describe() const;
+
+private:
+    using Brick = std::shared_ptr<std::vector<unsigned char>>;
+
+    bool build(const std::vector<std::string>& files, const std::string& brickFile);
+    bool open(const std::string& brickFile);
+    bool markPristine(bool value);
+    // Reports the first failed read or write, with the file lock held, and
+    // clears the stream. File access stops there: later reads yield zeros.
+    void ioFailure(const std::string& what) const;
+    // Writes slice z to its plane of every brick in the file, zero-padded,
+    // and of those cached
+    void storeSlice(int z, const unsigned char* in);
+    // The brick at (bx, by, bz), from the cache or loaded into it
+    Brick brick(int bx, int by, int bz) const;
+    Brick cached(int id) const;
+    size_t offset(int id) const { return HeaderBytes + static_cast<size_t>(id) * BrickBytes; }
+
+    static constexpr size_t HeaderBytes = 20;
+
+    int bricksX;
+    int bricksY;
+    int bricksZ;
+    size_t capacity; // in bricks
+    bool ready;
+    bool pristine; // the file holds exactly the slices
+
+    std::string path;
+    mutable std::fstream file;
+    mutable std::atomic<bool> ioFailed;
+    mutable std::mutex fileMutex;
+    // Most recently used first; the map points into the list
+    mutable std::list<int> recent;
+    mutable std::unordered_map<int, std::pair<Brick, std::list<int>::iterator>> cache;
+    mutable std::mutex cacheMutex;
+    mutable std::future<void> pending;
+};
@@ -0,0 +1,165 @@
+#include "Canny.h"
+#include "Gradient.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace Canny {
+
+namespace {
+
+enum Label : unsigned char { None = 0, Weak = 1, Strong = 2 };
+
+// Promotes the weak pixels 8-connected to the stacked strong ones, without
+// leaving rows [y0, y1)
+void flood(std::vector<unsigned char>& labels, std::vector<int>& stack, int w, int y0, int y1) {
+    while (!stack.empty()) {
+        const int i = stack.back();
+        stack.pop_back();
+        const int x = i % w;
+        const int y = i / w;
+        for (int ny = std::max(y - 1, y0); ny <= std::min(y + 1, y1 - 1); ++ny) {
+            for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, w - 1); ++nx) {
+                const int j = ny * w + nx;
+                if (labels[j] == Weak) {
+                    labels[j] = Strong;
+                    stack.push_back(j);
+                }
+            }
+        }
+    }
+}
+
+// Seeds the flood of row y with its weak pixels that touch a strong pixel of
+// the neighbouring band's row `other`
+void seedFromRow(std::vector<unsigned char>& labels, std::vector<int>& stack, int w, int y, int other) {
+    const unsigned char* row = labels.data() + static_cast<size_t>(y) * w;
+    const unsigned char* next = labels.data() + static_cast<size_t>(other) * w;
+    for (int x = 0; x < w; ++x) {
+        if (row[x] != Weak)
+            continue;
+        const bool touches = next[x] == Strong || (x > 0 && next[x - 1] == Strong) ||
+                             (x + 1 < w && next[x + 1] == Strong);
+        if (touches) {
+            labels[static_cast<size_t>(y) * w + x] = Strong;
+            stack.push_back(y * w + x);
+        }
+    }
+}
+
+} // namespace
+
+void detect(const unsigned char* src, int w, int h, int low, int high, const Border& border, unsigned char* dst) {
+    const size_t n = static_cast<size_t>(w) * h;
+    std::vector<int16_t> gx(n), gy(n);
+    Gradient::compute(src, w, h, EdgeKernelType::Sobel, border, gx.data(), gy.data(), nullptr);
+
+    const int32_t low2 = low * low;
+    const int32_t high2 = high * high;
+    const int bands = (h + BandRows - 1) / BandRows;
+    std::vector<unsigned char> labels(n);
+
+    // Non-maximum suppression and the first flood, band by band. The squared
+    // magnitude (no root needed for suppression or thresholds) is kept for
+    // three rows only, padded with a zero column either side, since outside
+    // the image the magnitude counts as zero.
+    #pragma omp parallel
+    {
+        std::vector<int32_t> window(3 * static_cast<size_t>(w + 2));
+        std::vector<int> stack;
+
+        auto fillRow = [&](int32_t* row, int y) {
+            row[0] = row[w + 1] = 0;
+            if (y < 0 || y >= h) {
+                std::fill(row + 1, row + w + 1, 0);
+                return;
+            }
+            const int16_t* rx = gx.data() + static_cast<size_t>(y) * w;
+            const int16_t* ry = gy.data() + static_cast<size_t>(y) * w;
+            #pragma omp simd
+            for (int x = 0; x < w; ++x)
+                row[x + 1] = rx[x] * rx[x] + ry[x] * ry[x];
+        };
+
+        #pragma omp for schedule(dynamic)
+        for (int b = 0; b < bands; ++b) {
+            const int y0 = b * BandRows;
+            const int y1 = std::min(y0 + BandRows, h);
+            int32_t* prev = window.data();
+            int32_t* cur = prev + w + 2;
+            int32_t* next = cur + w + 2;
+            fillRow(prev, y0 - 1);
+            fillRow(cur, y0);
+
+            for (int y = y0; y < y1; ++y) {
+                fillRow(next, y + 1);
+                const size_t offset = static_cast<size_t>(y) * w;
+                const int16_t* rx = gx.data() + offset;
+                const int16_t* ry = gy.data() + offset;
+                unsigned char* out = labels.data() + offset;
+
+                // Every direction is tested and the gradient's sector picks
+                // one, with tan(22.5) ~ 106 / 256, so the loop has no
+                // branches or gathers
+                #pragma omp simd
+                for (int x = 0; x < w; ++x) {
+                    const int32_t m = cur[x + 1];
+                    const int ax = std::abs(rx[x]);
+                    const int ay = std::abs(ry[x]);
+                    const int steep = ay * 256 > ax * 106;
+                    const int vertical = ay * 106 >= ax * 256;
+                    const int falling = (rx[x] ^ ry[x]) >= 0;
+
+                    const int across = (m > cur[x + 2]) & (m >= cur[x]);
+                    const int down = (m > next[x + 1]) & (m >= prev[x + 1]);
+                    const int fallingDiagonal = (m > next[x + 2]) & (m >= prev[x]);
+                    const int risingDiagonal = (m > prev[x + 2]) & (m >= next[x]);
+                    const int diagonal = falling ? fallingDiagonal : risingDiagonal;
+                    const int maximum = steep ? (vertical ? down : diagonal) : across;
+
+                    out[x] = static_cast<unsigned char>(((m >= low2) & maximum) * (Weak + (m >= high2)));
+                }
+                for (int x = 0; x < w; ++x)
+                    if (out[x] == Strong)
+                        stack.push_back(static_cast<int>(offset) + x);
+
+                std::swap(prev, cur);
+                std::swap(cur, next);
+            }
+            flood(labels, stack, w, y0, y1);
+        }
+    }
+
+    // Continue the floods across band boundaries until nothing changes
+    bool changed = bands > 1;
+    while (changed) {
+        changed = false;
+        for (int parity = 0; parity < 2; ++parity) {
+            #pragma omp parallel
+            {
+                std::vector<int> stack;
+
+                #pragma omp for schedule(dynamic) reduction(|| : changed)
+                for (int b = parity; b < bands; b += 2) {
+                    const int y0 = b * BandRows;
+                    const int y1 = std::min(y0 + BandRows, h);
+                    if (y0 > 0)
+                        seedFromRow(labels, stack, w, y0, y0 - 1);
+                    if (y1 < h)
+                        seedFromRow(labels, stack, w, y1 - 1, y1);
+                    if (!stack.empty()) {
+                        changed = true;
+                        flood(labels, stack, w, y0, y1);
+                    }
+                }
+            }
+        }
+    }
+
+    #pragma omp parallel for
+    for (long i = 0; i < static_cast<long>(n); ++i)
+        dst[i] = labels[i] == Strong ? 255 : 0;
+}
+
+} // namespace Canny
@@ -0,0 +1,23 @@
+#pragma once
+#include "Border.h"
+
+namespace Canny {
+
+// Rows per parallel band for suppression and hysteresis
+constexpr int BandRows = 64;
+
+// Canny edges of a single-channel w x h image into dst (w x h, 0 or 255).
+//
+// Sobel gradients come from the fused gradient pass. Non-maximum
+// suppression runs on the unsaturated magnitude in parallel row bands, with
+// the gradient direction quantized to 0, 45, 90 or 135 degrees. Pixels that
+// survive with magnitude >= high are edges, and those >= low are kept when
+// they are 8-connected to an edge. Thresholds are in Sobel magnitude units.
+// Smoothing is left to the caller.
+//
+// Hysteresis floods each band from its strong pixels in parallel, then
+// repeatedly continues the floods across band boundaries, even and odd bands
+// alternately so neighbours never write concurrently, until nothing changes.
+void detect(const unsigned char* src, int w, int h, int low, int high, const Border& border, unsigned char* dst);
+
+} // namespace Canny
@@ -0,0 +1,26 @@
+#include "Convolution.h"
+
+namespace Convolution {
+
+void apply(const Image& src, Image& dst, const Kernel<int>& kernel, int divisor, int offset, const Border& border) {
+    unsigned char* out = dst.data.get();
+    const int rowLen = src.w * src.channels;
+    run<int32_t>(src, kernel, [&](int index, int y, int n, const int32_t* acc) {
+        unsigned char* row = out + static_cast<size_t>(y) * rowLen + index;
+        for (int l = 0; l < n; ++l)
+            row[l] = static_cast<unsigned char>(std::min(std::max(acc[l] / divisor + offset, 0), 255));
+    }, border);
+}
+
+void apply(const Image& src, Image& dst, const Kernel<float>& kernel, float offset, const Border& border) {
+    unsigned char* out = dst.data.get();
+    const int rowLen = src.w * src.channels;
+    run<float>(src, kernel, [&](int index, int y, int n, const float* acc) {
+        unsigned char* row = out + static_cast<size_t>(y) * rowLen + index;
+        #pragma omp simd
+        for (int l = 0; l < n; ++l)
+            row[l] = static_cast<unsigned char>(std::min(std::max(acc[l] + offset, 0.0f), 255.0f));
+    }, border);
+}
+
+} // namespace Convolution
@@ -0,0 +1,109 @@
+#pragma once
+#include "Image.h"
+#include "Border.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// A small dense 2D kernel, row-major. The anchor is the centre tap, so odd
+// sizes are centred; even sizes (e.g. Roberts Cross) anchor one tap up-left.
+template <typename T>
+struct Kernel {
+    int width;
+    int height;
+    std::vector<T> weights;
+
+    T at(int i, int j) const { return weights[j * width + i]; }
+    // At least 1 x 1, with exactly width * height weights
+    bool valid() const { return width > 0 && height > 0 && weights.size() == static_cast<size_t>(width) * height; }
+};
+
+namespace Convolution {
+
+// Tiles are sized so a padded tile plus its accumulator row stay in L2
+constexpr int TileBytes = 1024;
+constexpr int TileRows = 64;
+
+// Cache-blocked driver shared by every convolution below.
+//
+// The image is cut into tiles of TileBytes x TileRows. Each tile is copied
+// together with its halo (the extra rows and columns the kernel reaches)
+// into a scratch buffer, resolving the halo with the border once per tile,
+// so the inner loops never test bounds. Tiles run in parallel.
+//
+// rowOp(acc, in, stride, c, n) computes n responses of one tile row, where
+// in points at the kernel's top-left tap in the padded tile. store(index, y,
+// n, acc) then receives them for row y, starting at interleaved byte index
+// `index` of that row.
+template <typename Acc, typename RowOp, typename Store>
+void runTiles(const Image& src, int kernelWidth, int kernelHeight, RowOp rowOp, Store store, const Border& border) {
+    const int w = src.w;
+    const int h = src.h;
+    const int c = src.channels;
+    const int ax = (kernelWidth - 1) / 2;
+    const int ay = (kernelHeight - 1) / 2;
+    const int tileWidth = std::max(1, TileBytes / c);
+    const int tilesX = (w + tileWidth - 1) / tileWidth;
+    const int tilesY = (h + TileRows - 1) / TileRows;
+    const unsigned char* data = src.data.get();
+
+    #pragma omp parallel
+    {
+        const size_t padStride = static_cast<size_t>(tileWidth + kernelWidth - 1) * c;
+        std::vector<unsigned char> pad(padStride * (TileRows + kernelHeight - 1));
+        std::vector<Acc> acc(static_cast<size_t>(tileWidth) * c);
+
+        #pragma omp for schedule(dynamic)
+        for (int tile = 0; tile < tilesX * tilesY; ++tile) {
+            const int x0 = (tile % tilesX) * tileWidth;
+            const int y0 = (tile / tilesX) * TileRows;
+            const int tw = std::min(tileWidth, w - x0);
+            const int th = std::min(TileRows, h - y0);
+            copyWithBorder(data, w, h, c, x0 - ax, x0 + tw + kernelWidth - 1 - ax,
+                           y0 - ay, y0 + th + kernelHeight - 1 - ay, border, pad.data(), padStride);
+
+            const int n = tw * c;
+            for (int yy = 0; yy < th; ++yy) {
+                rowOp(acc.data(), pad.data() + yy * padStride, padStride, c, n);
+                store(x0 * c, y0 + yy, n, acc.data());
+            }
+        }
+    }
+}
+
+// Convolution with a kernel known only at run time. Each tile row is
+// accumulated one non-zero tap at a time: the tap's weight times a
+// contiguous run of the padded row is added to the whole accumulator row.
+template <typename Acc, typename T, typename Store>
+void run(const Image& src, const Kernel<T>& kernel, Store store, const Border& border = Border()) {
+    if (!kernel.valid()) {
+        std::cerr << "Convolution kernel must be at least 1 x 1 with width * height weights." << std::endl;
+        return;
+    }
+    // Non-zero taps as (offset in columns and rows of the padded tile, weight)
+    struct Tap { int dx; int dy; Acc weight; };
+    std::vector<Tap> taps;
+    for (int j = 0; j < kernel.height; ++j)
+        for (int i = 0; i < kernel.width; ++i)
+            if (kernel.at(i, j) != T(0))
+                taps.push_back({i, j, static_cast<Acc>(kernel.at(i, j))});
+
+    runTiles<Acc>(src, kernel.width, kernel.height, [&](Acc* acc, const unsigned char* in, size_t stride, int c, int n) {
+        std::fill(acc, acc + n, Acc(0));
+        for (const Tap& tap : taps) {
+            const unsigned char* row = in + tap.dy * stride + tap.dx * c;
+            #pragma omp simd
+            for (int l = 0; l < n; ++l)
+                acc[l] += tap.weight * row[l];
+        }
+    }, store, border);
+}
+
+// Convolve into dst (same size as src): acc / divisor + offset, truncated
+// and saturated to [0, 255]
+void apply(const Image& src, Image& dst, const Kernel<int>& kernel, int divisor = 1, int offset = 0,
+           const Border& border = Border());
+void apply(const Image& src, Image& dst, const Kernel<float>& kernel, float offset = 0.0f,
+           const Border& border = Border());
+
+} // namespace Convolution
@@ -0,0 +1,206 @@
+#include "Corners.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace Corners {
+
+namespace {
+
+// Scales an operator's gradient so a full black-to-white step gives 1
+float gradientScale(EdgeKernelType type) {
+    switch (type) {
+        case EdgeKernelType::Prewitt: return 1.0f / (3 * 255);
+        case EdgeKernelType::Scharr: return 1.0f / (16 * 255);
+        case EdgeKernelType::Robert: return 1.0f / 255;
+        default: return 1.0f / (4 * 255);
+    }
+}
+
+} // namespace
+
+void response(const unsigned char* src, int w, int h, CornerType type, EdgeKernelType gradient,
+              const std::vector<float>& window, float k, const Border& border, float* response) {
+    const size_t n = static_cast<size_t>(w) * h;
+    std::vector<int16_t> gx(n), gy(n);
+    Gradient::compute(src, w, h, gradient, border, gx.data(), gy.data(), nullptr);
+
+    const int r = static_cast<int>(window.size()) / 2;
+    const int padded = w + 2 * r;
+    const float scale = gradientScale(gradient);
+    const float scale2 = scale * scale;
+    const int bands = (h + BandRows - 1) / BandRows;
+
+    // Source column of each padded column, -1 outside a Constant border
+    std::vector<int> columns(padded);
+    for (int x = 0; x < padded; ++x)
+        columns[x] = borderIndex(x - r, w, border.mode);
+
+    #pragma omp parallel
+    {
+        // Horizontally summed products of the band and its halo rows, then
+        // one vertically summed row of each
+        const size_t bandSize = static_cast<size_t>(BandRows + 2 * r) * w;
+        std::vector<float> hxx(bandSize), hxy(bandSize), hyy(bandSize);
+        std::vector<float> pxx(padded), pxy(padded), pyy(padded);
+        std::vector<float> sxx(w), sxy(w), syy(w);
+
+        #pragma omp for schedule(dynamic)
+        for (int b = 0; b < bands; ++b) {
+            const int y0 = b * BandRows;
+            const int y1 = std::min(y0 + BandRows, h);
+
+            for (int v = y0 - r; v < y1 + r; ++v) {
+                const size_t slot = static_cast<size_t>(v - (y0 - r)) * w;
+                const int y = borderIndex(v, h, border.mode);
+                if (y < 0) {
+                    std::fill(hxx.begin() + slot, hxx.begin() + slot + w, 0.0f);
+                    std::fill(hxy.begin() + slot, hxy.begin() + slot + w, 0.0f);
+                    std::fill(hyy.begin() + slot, hyy.begin() + slot + w, 0.0f);
+                    continue;
+                }
+                const int16_t* rx = gx.data() + static_cast<size_t>(y) * w;
+                const int16_t* ry = gy.data() + static_cast<size_t>(y) * w;
+                // Interior columns are contiguous; only the halo goes through
+                // the column map
+                #pragma omp simd
+                for (int x = 0; x < w; ++x) {
+                    const float dx = rx[x];
+                    const float dy = ry[x];
+                    pxx[x + r] = dx * dx * scale2;
+                    pxy[x + r] = dx * dy * scale2;
+                    pyy[x + r] = dy * dy * scale2;
+                }
+                auto halo = [&](int from, int to) {
+                    for (int x = from; x < to; ++x) {
+                        const int sx = columns[x];
+                        const float dx = sx < 0 ? 0.0f : rx[sx];
+                        const float dy = sx < 0 ? 0.0f : ry[sx];
+                        pxx[x] = dx * dx * scale2;
+                        pxy[x] = dx * dy * scale2;
+                        pyy[x] = dy * dy * scale2;
+                    }
+                };
+                halo(0, r);
+                halo(r + w, padded);
+
+                // Tap-outer, so every inner loop is a contiguous multiply-add;
+                // the first tap initialises the sums
+                float* ox = hxx.data() + slot;
+                float* oxy = hxy.data() + slot;
+                float* oy = hyy.data() + slot;
+                for (int i = 0; i <= 2 * r; ++i) {
+                    const float weight = window[i];
+                    if (i == 0) {
+                        #pragma omp simd
+                        for (int x = 0; x < w; ++x) {
+                            ox[x] = weight * pxx[x];
+                            oxy[x] = weight * pxy[x];
+                            oy[x] = weight * pyy[x];
+                        }
+                        continue;
+                    }
+                    #pragma omp simd
+                    for (int x = 0; x < w; ++x) {
+                        ox[x] += weight * pxx[x + i];
+                        oxy[x] += weight * pxy[x + i];
+                        oy[x] += weight * pyy[x + i];
+                    }
+                }
+            }
+
+            for (int y = y0; y < y1; ++y) {
+                for (int j = 0; j <= 2 * r; ++j) {
+                    const size_t slot = static_cast<size_t>(y - y0 + j) * w;
+                    const float weight = window[j];
+                    if (j == 0) {
+                        #pragma omp simd
+                        for (int x = 0; x < w; ++x) {
+                            sxx[x] = weight * hxx[slot + x];
+                            sxy[x] = weight * hxy[slot + x];
+                            syy[x] = weight * hyy[slot + x];
+                        }
+                        continue;
+                    }
+                    #pragma omp simd
+                    for (int x = 0; x < w; ++x) {
+                        sxx[x] += weight * hxx[slot + x];
+                        sxy[x] += weight * hxy[slot + x];
+                        syy[x] += weight * hyy[slot + x];
+                    }
+                }
+
+                float* out = response + static_cast<size_t>(y) * w;
+                if (type == CornerType::Harris) {
+                    #pragma omp simd
+                    for (int x = 0; x < w; ++x) {
+                        const float trace = sxx[x] + syy[x];
+                        out[x] = sxx[x] * syy[x] - sxy[x] * sxy[x] - k * trace * trace;
+                    }
+                } else {
+                    #pragma omp simd
+                    for (int x = 0; x < w; ++x) {
+                        const float half = 0.5f * (sxx[x] - syy[x]);
+                        out[x] = 0.5f * (sxx[x] + syy[x]) - std::sqrt(half * half + sxy[x] * sxy[x]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::vector<Keypoint> keypoints(const float* response, int w, int h, float threshold, int suppressionRadius,
+                                int maxCount) {
+    const int s = std::max(suppressionRadius, 0);
+    std::vector<Keypoint> found;
+
+    #pragma omp parallel
+    {
+        std::vector<Keypoint> local;
+
+        #pragma omp for schedule(dynamic, 16) nowait
+        for (int y = 0; y < h; ++y) {
+            const float* row = response + static_cast<size_t>(y) * w;
+            for (int x = 0; x < w; ++x) {
+                const float value = row[x];
+                if (value <= threshold)
+                    continue;
+                // Strictly above the neighbours before it in raster order and
+                // not below those after it, so a plateau keeps one point
+                bool maximum = true;
+                for (int ny = std::max(y - s, 0); ny <= std::min(y + s, h - 1) && maximum; ++ny) {
+                    const float* other = response + static_cast<size_t>(ny) * w;
+                    for (int nx = std::max(x - s, 0); nx <= std::min(x + s, w - 1); ++nx) {
+                        const bool before = ny < y || (ny == y && nx < x);
+                        if (before ? other[nx] >= value : other[nx] > value) {
+                            maximum = false;
+                            break;
+                        }
+                    }
+                }
+                if (maximum)
+                    local.push_back({x, y, value});
+            }
+        }
+
+        #pragma omp critical
+        found.insert(found.end(), local.begin(), local.end());
+    }
+
+    // Strongest first, raster order among equals so the result is the same
+    // for any thread count
+    auto stronger = [](const Keypoint& a, const Keypoint& b) {
+        if (a.response != b.response)
+            return a.response > b.response;
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    };
+    if (maxCount > 0 && static_cast<size_t>(maxCount) < found.size()) {
+        std::partial_sort(found.begin(), found.begin() + maxCount, found.end(), stronger);
+        found.resize(maxCount);
+    } else {
+        std::sort(found.begin(), found.end(), stronger);
+    }
+    return found;
+}
+
+} // namespace Corners
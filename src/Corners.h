@@ -0,0 +1,38 @@
+#pragma once
+#include "Border.h"
+#include "Gradient.h"
+#include <vector>
+
+// Harris: det(M) - k trace(M)^2. Shi-Tomasi: the smaller eigenvalue of M.
+enum class CornerType { Harris, ShiTomasi };
+
+struct Keypoint {
+    int x;
+    int y;
+    float response;
+};
+
+namespace Corners {
+
+// Rows per parallel band
+constexpr int BandRows = 64;
+
+// Corner response of a single-channel w x h image into response (w x h).
+//
+// The gradients come from the fused gradient pass with the chosen kernel
+// (Sobel, Prewitt, Scharr or Roberts). The structure tensor M = sum of
+// window * [gx^2, gx gy; gx gy, gy^2] is summed with the separable 1D window
+// (normalised weights of odd length, e.g. a box or a Gaussian), horizontally
+// per row and then vertically, and the vertical pass evaluates the response
+// in the same loop. The window reads products outside the image through the
+// border; a Constant border counts as flat.
+void response(const unsigned char* src, int w, int h, CornerType type, EdgeKernelType gradient,
+              const std::vector<float>& window, float k, const Border& border, float* response);
+
+// The strongest local maxima of a response map: responses above threshold
+// that are the largest within suppressionRadius (ties go to the first in
+// raster order), strongest first, at most maxCount (all if maxCount <= 0)
+std::vector<Keypoint> keypoints(const float* response, int w, int h, float threshold, int suppressionRadius,
+                                int maxCount);
+
+} // namespace Corners
@@ -1,18 +1,17 @@
 #include "Filter.h"
+#include "Canny.h"
+#include "FixedPointGaussian.h"
+#include "MedianHistogram.h"
+#include "MedianNetwork.h"
 #include <vector>
 #include <random> // For random number generation
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <mutex>
 
 
-// Kernel Definitions
-const int Filter::SobelX[3][3] = {{-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1}};
-const int Filter::SobelY[3][3] = {{-1, -2, -1}, {0, 0, 0}, {1, 2, 1}};
-const int Filter::PrewittX[3][3] = {{-1, 0, 1}, {-1, 0, 1}, {-1, 0, 1}};
-const int Filter::PrewittY[3][3] = {{-1, -1, -1}, {0, 0, 0}, {1, 1, 1}};
-const int Filter::ScharrX[3][3] = {{-3, 0, 3}, {-10, 0, 10}, {-3, 0, 3}};
-const int Filter::ScharrY[3][3] = {{-3, -10, -3}, {0, 0, 0}, {3, 10, 3}};
-const int Filter::RobertX[2][2] = {{1, 0}, {0,-1}};
-const int Filter::RobertY[2][2] = {{0, 1}, {-1,0}};
-
 void Filter::convertToGrayscale(Image& image) {
     if (image.channels < 3) {
         std::cerr << "Image is already grayscale." << std::endl;
@@ -294,99 +293,558 @@ void Filter::addSaltAndPepperNoise(Image& image, float saltProbability, float pe
 
 
 
-// std::vector<std::vector<float>> Filter::createGaussianKernel(int radius, float sigma) {
-//     int size = 2 * radius + 1; // Size of the kernel
-//     std::vector<std::vector<float>> kernel(size, std::vector<float>(size));
-//     float sum = 0.0; // Used for normalization later
-
-//     // Compute the Gaussian kernel
-//     for (int i = -radius; i <= radius; i++) {
-//         for (int j = -radius; j <= radius; j++) {
-//             float exponent = -(i*i + j*j) / (2 * sigma * sigma);
-//             kernel[i + radius][j + radius] = std::exp(exponent);
-//             sum += kernel[i + radius][j + radius];
-//         }
-//     }
-
-//     // Normalize the Gaussian kernel to ensure the sum of all elements is 1
-//     for (int i = 0; i < size; i++) {
-//         for (int j = 0; j < size; j++) {
-//             kernel[i][j] /= sum;
-//         }
-//     }
-
-//     return kernel;
-// }
-
-
-
-
-// void Filter::edgeDetection(Image& image, const std::vector<EdgeKernelType>& kernels) {
-//     // Move the implementation from edge_detection.cpp here
-//     // Adapt it to work within the Filter class and with the Image class
-//     unsigned char* inputImage = image.data.get();
-//     unsigned char* outputImage = new unsigned char[image.w * image.h];
-
-//     for (const auto& kernelType : kernels) {
-//         if (kernelType == EdgeKernelType::Robert) {
-//             std::memcpy(outputImage, inputImage, image.w * image.h * sizeof(unsigned char));
-
-//             for (int y = 0; y < image.h - 1; ++y) {
-//                 for (int x = 0; x < image.w - 1; ++x) {
-//                     int gx = 0, gy = 0;
-//                     for (int i = 0; i <= 1; ++i) {
-//                         for (int j = 0; j <= 1; ++j) {
-//                             int pixelIndex = (y + i) * image.w + (x + j);
-//                             gx += outputImage[pixelIndex] * RobertX[i][j];
-//                             gy += outputImage[pixelIndex] * RobertY[i][j];
-//                         }
-//                     }
-//                     int magnitude = static_cast<int>(sqrt(gx * gx + gy * gy));
-//                     inputImage[y * image.w + x] = static_cast<unsigned char>(magnitude > 255 ? 255 : magnitude);
-//                 }
-//             }
-//         } else {
-//             const int (*kernelX)[3][3];
-//             const int (*kernelY)[3][3];
-        
-
-//             switch (kernelType) {
-//                 case EdgeKernelType::Sobel:
-//                     kernelX = &SobelX;
-//                     kernelY = &SobelY;
-//                     break;
-//                 case EdgeKernelType::Prewitt:
-//                     kernelX = &PrewittX;
-//                     kernelY = &PrewittY;
-//                     break;
-//                 case EdgeKernelType::Scharr:
-//                     kernelX = &ScharrX;
-//                     kernelY = &ScharrY;
-//                     break;
-//                 default:
-//                     break;
-//             }
-
-//             std::memcpy(outputImage, inputImage, image.w * image.h * sizeof(unsigned char)); // Copy input to output for processing
-
-//             for (int y = 1; y < image.h - 1; ++y) {
-//                 for (int x = 1; x < image.w - 1; ++x) {
-//                     int gx = 0, gy = 0;
-//                     for (int i = -1; i <= 1; ++i) {
-//                         for (int j = -1; j <= 1; ++j) {
-//                             int pixelIndex = ((y + i) * image.w + (x + j));
-//                             gx += outputImage[pixelIndex] * (*kernelX)[i + 1][j + 1];
-//                             gy += outputImage[pixelIndex] * (*kernelY)[i + 1][j + 1];
-//                         }
-//                     }
-//                     int magnitude = static_cast<int>(sqrt(gx * gx + gy * gy));
-//                     inputImage[y * image.w + x] = static_cast<unsigned char>(magnitude);
-//                 }
-//             }
-//             }
-//     }
-
-//     delete[] outputImage;
-// }
+void Filter::applyBoxBlur(Image& image, int kernelSize, const Border& border) {
+    // Separable running-sum box filter: each pass adds the sample entering the
+    // window and subtracts the one leaving it, so the cost per pixel does not
+    // depend on kernelSize.
+    if (kernelSize < 1 || kernelSize % 2 == 0 || kernelSize > 255) {
+        std::cerr << "Box blur kernel size must be odd and between 1 and 255." << std::endl;
+        return;
+    }
+
+    const int w = image.w;
+    const int h = image.h;
+    const int c = image.channels;
+    const int r = kernelSize / 2;
+    const int rowLen = w * c;
+    unsigned char* data = image.data.get();
+
+    // Horizontal pass over rows padded with the border, so the running sum
+    // never needs an index check: sums of at most 255 * 255 fit in 16 bits
+    std::vector<uint16_t> rowSums(static_cast<size_t>(rowLen) * h);
+
+    #pragma omp parallel
+    {
+        // One spare column so the last update of the running sum stays in bounds
+        std::vector<unsigned char> padded(static_cast<size_t>(w + 2 * r + 1) * c);
+
+        #pragma omp for
+        for (int y = 0; y < h; ++y) {
+            copyWithBorder(data, w, h, c, -r, w + r + 1, y, y + 1, border, padded.data(), padded.size());
+            uint16_t* dst = rowSums.data() + static_cast<size_t>(y) * rowLen;
+            for (int ch = 0; ch < c; ++ch) {
+                const unsigned char* src = padded.data() + ch;
+                unsigned int sum = 0;
+                for (int i = 0; i < kernelSize; ++i)
+                    sum += src[i * c];
+                for (int x = 0; x < w; ++x) {
+                    dst[x * c + ch] = static_cast<uint16_t>(sum);
+                    sum += src[(x + kernelSize) * c] - src[x * c];
+                }
+            }
+        }
+    }
+
+    // Rows -r .. h + r - 1 of the horizontal result, resolved through the
+    // border once; a Constant border contributes a row of constant sums
+    const std::vector<uint16_t> constantRow(rowLen, static_cast<uint16_t>(kernelSize * border.value));
+    std::vector<const uint16_t*> rows(h + 2 * r + 1);
+    for (int y = -r; y <= h + r; ++y) {
+        const int sy = borderIndex(y, h, border.mode);
+        rows[y + r] = sy < 0 ? constantRow.data() : rowSums.data() + static_cast<size_t>(sy) * rowLen;
+    }
+
+    // Vertical pass: one running sum per column, updated a whole row at a
+    // time so the inner loops vectorise across columns. Column strips are
+    // independent and run in parallel.
+    const int area = kernelSize * kernelSize;
+    // Exact floor(sum / area) as a multiply and shift for sum <= 255 * area
+    const uint64_t reciprocal = (uint64_t(1) << 42) / area + 1;
+    const int stripWidth = 1024;
+
+    #pragma omp parallel for
+    for (int x0 = 0; x0 < rowLen; x0 += stripWidth) {
+        const int n = std::min(stripWidth, rowLen - x0);
+        std::vector<uint32_t> colSum(n, 0);
+
+        for (int i = 0; i < kernelSize; ++i) {
+            const uint16_t* next = rows[i] + x0;
+            for (int x = 0; x < n; ++x)
+                colSum[x] += next[x];
+        }
+
+        for (int y = 0; y < h; ++y) {
+            unsigned char* out = data + static_cast<size_t>(y) * rowLen + x0;
+            const uint16_t* entering = rows[y + kernelSize] + x0;
+            const uint16_t* leaving = rows[y] + x0;
+            #pragma omp simd
+            for (int x = 0; x < n; ++x) {
+                out[x] = static_cast<unsigned char>((colSum[x] * reciprocal) >> 42);
+                colSum[x] += entering[x] - leaving[x];
+            }
+        }
+    }
+}
+
+
+namespace {
+
+// Largest total (L1) deviation of the 8.8 fixed-point taps from the exact
+// weights for which the fixed-point kernel is still considered a Gaussian
+constexpr float MaxFixedPointError = 0.25f;
+
+// Normalised 1D Gaussian weights, plus the same weights in 8.8 fixed point
+// (summing to exactly 256) for the integer blur passes; empty when 8
+// fractional bits cannot represent the kernel.
+struct GaussianKernel {
+    std::vector<float> weights;
+    std::vector<uint16_t> fixedPoint;
+};
+
+const GaussianKernel& cachedGaussianKernel(int radius, float sigma) {
+    static std::map<std::pair<int, float>, GaussianKernel> cache;
+    static std::mutex cacheMutex;
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto found = cache.find({radius, sigma});
+    if (found != cache.end())
+        return found->second;
+
+    GaussianKernel kernel;
+    int size = 2 * radius + 1;
+    kernel.weights.resize(size);
+    float sum = 0.0f;
+    for (int i = -radius; i <= radius; i++) {
+        kernel.weights[i + radius] = std::exp(-(i * i) / (2 * sigma * sigma));
+        sum += kernel.weights[i + radius];
+    }
+    for (float& weight : kernel.weights)
+        weight /= sum;
+
+    // Round every tap down, then hand the missing units out symmetrically to
+    // the taps that lost the most, so the fixed-point kernel sums to exactly
+    // 256 without any tap going negative or past 256
+    std::vector<int> fixed(size);
+    std::vector<float> lost(size);
+    int missing = 256;
+    for (int i = 0; i < size; i++) {
+        const float scaled = kernel.weights[i] * 256.0f;
+        fixed[i] = static_cast<int>(scaled);
+        lost[i] = scaled - fixed[i];
+        missing -= fixed[i];
+    }
+    std::vector<int> order(radius);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return lost[a] > lost[b]; });
+    for (int k = 0; missing >= 2 && radius > 0; k = (k + 1) % radius, missing -= 2) {
+        ++fixed[order[k]];
+        ++fixed[size - 1 - order[k]];
+    }
+    fixed[radius] += missing;
+
+    // Kernels too wide for 8 fractional bits, whose rounded taps misplace
+    // more than MaxFixedPointError of the weight, are left empty
+    float error = 0.0f;
+    for (int i = 0; i < size; i++)
+        error += std::abs(fixed[i] / 256.0f - kernel.weights[i]);
+    if (error <= MaxFixedPointError)
+        kernel.fixedPoint.assign(fixed.begin(), fixed.end());
+
+    return cache.emplace(std::make_pair(radius, sigma), std::move(kernel)).first->second;
+}
+
+} // namespace
+
+const std::vector<float>& Filter::createGaussianKernel(int radius, float sigma) {
+    return cachedGaussianKernel(radius, sigma).weights;
+}
+
+const std::vector<uint16_t>& Filter::createFixedPointGaussianKernel(int radius, float sigma) {
+    return cachedGaussianKernel(radius, sigma).fixedPoint;
+}
+
+void Filter::applyGaussianBlur(Image& image, int radius, float sigma, const Border& border) {
+    // Separable Gaussian: a horizontal then a vertical 1D pass with 8.8 fixed
+    // point weights. The horizontal pass keeps 8 fractional bits in 16-bit
+    // intermediates and the vertical pass truncates the 16 fractional bits,
+    // which stays within one grey level of the exact 2D float convolution.
+    if (radius < 0 || sigma <= 0.0f) {
+        std::cerr << "Gaussian blur needs a non-negative radius and a positive sigma." << std::endl;
+        return;
+    }
+    if (sigma >= RecursiveGaussianSigma && radius >= std::ceil(RecursiveGaussianSpan * sigma) &&
+        (border.mode == BorderMode::Clamp || border.mode == BorderMode::Constant)) {
+        // Wide kernels: the IIR backend costs the same for any sigma. It has
+        // infinite support, so it only stands in for a FIR kernel that
+        // already reaches the Gaussian's tails. Reflect and Wrap have no
+        // closed-form start state and stay on the FIR path.
+        applyRecursiveGaussian(image, sigma, border);
+        return;
+    }
+
+    const std::vector<uint16_t>& kernel = cachedGaussianKernel(radius, sigma).fixedPoint;
+    if (kernel.empty()) {
+        std::cerr << "Gaussian radius " << radius << " with sigma " << sigma
+                  << " is too wide for the fixed-point kernel." << std::endl;
+        return;
+    }
+    const int w = image.w;
+    const int h = image.h;
+    const int rowLen = w * image.channels;
+    unsigned char* data = image.data.get();
+
+    std::vector<uint16_t> rowPass(static_cast<size_t>(rowLen) * h);
+    FixedPointGaussian::rows(data, w, h, image.channels, kernel, border, rowPass.data());
+    FixedPointGaussian::columns(rowPass.data(), rowLen, h, kernel, border, data);
+}
+
+
+namespace {
+
+// Right-boundary initialisation for the anti-causal pass of a third-order
+// recursive filter (Triggs & Sdika, 2006). Beyond the last sample the input
+// is held constant, so the anti-causal start state is that constant plus a
+// linear function of how far the last three causal outputs are from it. The
+// 3x3 map is found by running the recursion on each unit deviation, which
+// avoids hand-expanding the closed form.
+void recursiveBoundaryMatrix(double B, double a1, double a2, double a3, double q, float M[3][3]) {
+    const int length = static_cast<int>(40.0 * q) + 64;
+    std::vector<double> e(length), g(length + 3, 0.0);
+    for (int j = 0; j < 3; ++j) {
+        double e1 = (j == 0), e2 = (j == 1), e3 = (j == 2);
+        for (int n = 0; n < length; ++n) {
+            e[n] = a1 * e1 + a2 * e2 + a3 * e3;
+            e3 = e2; e2 = e1; e1 = e[n];
+        }
+        for (int n = length - 1; n >= 0; --n)
+            g[n] = B * e[n] + a1 * g[n + 1] + a2 * g[n + 2] + a3 * g[n + 3];
+        for (int i = 0; i < 3; ++i)
+            M[i][j] = static_cast<float>(g[i]);
+    }
+}
+
+} // namespace
+
+void Filter::applyRecursiveGaussian(Image& image, float sigma, const Border& border) {
+    // Young & van Vliet (1995) recursive Gaussian: a third-order causal
+    // filter followed by the same filter run anti-causally, applied along
+    // rows and then columns. Work per pixel is fixed regardless of sigma.
+    // Outside the image the signal is held at the edge sample (Clamp) or at
+    // the border value (Constant): the causal pass starts in the steady state
+    // of that signal and the anti-causal pass in the Triggs & Sdika state.
+    const double q = sigma >= 2.5f
+        ? 0.98711 * sigma - 0.96330
+        : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+    const double q2 = q * q;
+    const double q3 = q2 * q;
+    const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+    const double a1d = (2.44413 * q + 2.85619 * q2 + 1.26661 * q3) / b0;
+    const double a2d = -(1.4281 * q2 + 1.26661 * q3) / b0;
+    const double a3d = 0.422205 * q3 / b0;
+    const double Bd = 1.0 - (a1d + a2d + a3d);
+    const float a1 = static_cast<float>(a1d);
+    const float a2 = static_cast<float>(a2d);
+    const float a3 = static_cast<float>(a3d);
+    const float B = static_cast<float>(Bd);
+    float M[3][3];
+    recursiveBoundaryMatrix(Bd, a1d, a2d, a3d, q, M);
+
+    const int w = image.w;
+    const int h = image.h;
+    const int c = image.channels;
+    const int rowLen = w * c;
+    unsigned char* data = image.data.get();
+    std::vector<float> buffer(static_cast<size_t>(rowLen) * h);
+
+    // The filter has unit gain at DC, so an offset passes straight through.
+    // Keeping every value near or above it stops the tails that decay into
+    // black regions from becoming denormals, which are very slow on x86.
+    const float bias = 1.0f;
+    const bool constant = border.mode == BorderMode::Constant;
+    const float outside = border.value + bias;
+
+    // Horizontal pass, one row per iteration
+    #pragma omp parallel for
+    for (int y = 0; y < h; ++y) {
+        const unsigned char* src = data + static_cast<size_t>(y) * rowLen;
+        float* row = buffer.data() + static_cast<size_t>(y) * rowLen;
+        for (int ch = 0; ch < c; ++ch) {
+            float p1 = constant ? outside : src[ch] + bias, p2 = p1, p3 = p1;
+            for (int x = 0; x < w; ++x) {
+                float v = B * (src[x * c + ch] + bias) + a1 * p1 + a2 * p2 + a3 * p3;
+                row[x * c + ch] = v;
+                p3 = p2; p2 = p1; p1 = v;
+            }
+
+            const float edge = constant ? outside : src[(w - 1) * c + ch] + bias;
+            const float d1 = p1 - edge, d2 = p2 - edge, d3 = p3 - edge;
+            p1 = edge + M[0][0] * d1 + M[0][1] * d2 + M[0][2] * d3;
+            p2 = edge + M[1][0] * d1 + M[1][1] * d2 + M[1][2] * d3;
+            p3 = edge + M[2][0] * d1 + M[2][1] * d2 + M[2][2] * d3;
+            for (int x = w - 1; x >= 0; --x) {
+                float v = B * row[x * c + ch] + a1 * p1 + a2 * p2 + a3 * p3;
+                row[x * c + ch] = v;
+                p3 = p2; p2 = p1; p1 = v;
+            }
+        }
+    }
+
+    // Vertical pass over blocks of columns. The recursion state for a whole
+    // block advances one row at a time, so the inner loops run across
+    // contiguous columns and vectorise; blocks are independent.
+    const int blockWidth = 256;
+    #pragma omp parallel for
+    for (int x0 = 0; x0 < rowLen; x0 += blockWidth) {
+        const int n = std::min(blockWidth, rowLen - x0);
+        std::vector<float> state(4 * static_cast<size_t>(n));
+        float* p1 = state.data();
+        float* p2 = p1 + n;
+        float* p3 = p2 + n;
+        float* edge = p3 + n;
+        auto row = [&](int y) { return buffer.data() + static_cast<size_t>(y) * rowLen + x0; };
+
+        // Beyond the top and bottom rows a Constant border is still constant
+        // after the horizontal pass, which has unit gain at DC
+        if (constant) {
+            std::fill(p1, p1 + n, outside);
+            std::fill(edge, edge + n, outside);
+        } else {
+            std::copy(row(0), row(0) + n, p1);
+            std::copy(row(h - 1), row(h - 1) + n, edge);
+        }
+        std::copy(p1, p1 + n, p2);
+        std::copy(p1, p1 + n, p3);
+        for (int y = 0; y < h; ++y) {
+            float* r = row(y);
+            #pragma omp simd
+            for (int x = 0; x < n; ++x) {
+                float v = B * r[x] + a1 * p1[x] + a2 * p2[x] + a3 * p3[x];
+                r[x] = v;
+                p3[x] = p2[x]; p2[x] = p1[x]; p1[x] = v;
+            }
+        }
+
+        #pragma omp simd
+        for (int x = 0; x < n; ++x) {
+            const float d1 = p1[x] - edge[x], d2 = p2[x] - edge[x], d3 = p3[x] - edge[x];
+            p1[x] = edge[x] + M[0][0] * d1 + M[0][1] * d2 + M[0][2] * d3;
+            p2[x] = edge[x] + M[1][0] * d1 + M[1][1] * d2 + M[1][2] * d3;
+            p3[x] = edge[x] + M[2][0] * d1 + M[2][1] * d2 + M[2][2] * d3;
+        }
+        for (int y = h - 1; y >= 0; --y) {
+            float* r = row(y);
+            unsigned char* out = data + static_cast<size_t>(y) * rowLen + x0;
+            #pragma omp simd
+            for (int x = 0; x < n; ++x) {
+                float v = B * r[x] + a1 * p1[x] + a2 * p2[x] + a3 * p3[x];
+                p3[x] = p2[x]; p2[x] = p1[x]; p1[x] = v;
+                out[x] = static_cast<unsigned char>(std::min(std::max(v - bias + 0.5f, 0.0f), 255.0f));
+            }
+        }
+    }
+}
+
+
+namespace {
+
+using MedianNetwork::forgetfulMedianLanes;
+using MedianNetwork::sort5Lanes;
+using MedianNetwork::sortLanes;
+constexpr int MedianLanes = MedianNetwork::Lanes;
+
+// 3x3 and 5x5 medians. For each output row the source rows are padded with
+// the border and sorted column-wise once; every window then reuses
+// the sorted columns it shares with its neighbours. For 3x3 the median is
+// the median of (max of column minima, median of column medians, min of
+// column maxima). For 5x5 the five sorted columns are also sorted across,
+// which leaves only 13 of the 25 values able to be the median, and the
+// median of those 13 is taken by forgetful selection.
+template <int KernelSize>
+void medianNetworkRow(const unsigned char* src, unsigned char* dst, int w, int h, int c, int y,
+                      const Border& border, std::vector<unsigned char>& columns) {
+    static_assert(KernelSize == 3 || KernelSize == 5, "sorting networks exist for 3x3 and 5x5 only");
+    constexpr int r = KernelSize / 2;
+    const int rowLen = w * c;
+    const size_t paddedLen = static_cast<size_t>(w + 2 * r) * c + MedianLanes;
+
+    unsigned char* col[KernelSize];
+    for (int i = 0; i < KernelSize; ++i) {
+        col[i] = columns.data() + i * paddedLen;
+        copyWithBorder(src, w, h, c, -r, w + r, y + i - r, y + i - r + 1, border, col[i], paddedLen);
+    }
+    const int sortLen = (w + 2 * r) * c;
+    if constexpr (KernelSize == 3) {
+        sortLanes(col[0], col[1], sortLen);
+        sortLanes(col[1], col[2], sortLen);
+        sortLanes(col[0], col[1], sortLen);
+    } else {
+        sort5Lanes(col, sortLen);
+    }
+
+    unsigned char* out = dst + static_cast<size_t>(y) * rowLen;
+    unsigned char block[KernelSize * KernelSize][MedianLanes];
+    for (int i0 = 0; i0 < rowLen; i0 += MedianLanes) {
+        const int n = std::min(MedianLanes, rowLen - i0);
+        if constexpr (KernelSize == 3) {
+            // block[rank * 3 + t] is the rank-th smallest of window column t
+            for (int t = 0; t < 3; ++t)
+                for (int rank = 0; rank < 3; ++rank)
+                    std::copy(col[rank] + i0 + t * c, col[rank] + i0 + t * c + MedianLanes, block[rank * 3 + t]);
+            unsigned char* lo = block[0];
+            unsigned char* mid = block[4];
+            unsigned char* hi = block[6];
+            sortLanes(block[1], lo); sortLanes(block[2], lo);
+            sortLanes(hi, block[7]); sortLanes(hi, block[8]);
+            sortLanes(block[3], mid); sortLanes(mid, block[5]); sortLanes(block[3], mid);
+            sortLanes(lo, mid); sortLanes(mid, hi); sortLanes(lo, mid);
+            std::copy(mid, mid + n, out + i0);
+        } else {
+            // block[rank * 5 + t] is the rank-th smallest of window column t
+            for (int t = 0; t < 5; ++t)
+                for (int rank = 0; rank < 5; ++rank)
+                    std::copy(col[rank] + i0 + t * c, col[rank] + i0 + t * c + MedianLanes, block[rank * 5 + t]);
+            for (int rank = 0; rank < 5; ++rank) {
+                unsigned char* across[5] = {block[rank * 5], block[rank * 5 + 1], block[rank * 5 + 2],
+                                            block[rank * 5 + 3], block[rank * 5 + 4]};
+                sort5Lanes(across);
+            }
+            static const int candidates[13] = {3, 4, 7, 8, 9, 11, 12, 13, 15, 16, 17, 20, 21};
+            unsigned char* pool[13];
+            for (int i = 0; i < 13; ++i)
+                pool[i] = block[candidates[i]];
+            const unsigned char* median = forgetfulMedianLanes<13>(pool);
+            std::copy(median, median + n, out + i0);
+        }
+    }
+}
+
+} // namespace
+
+void Filter::applyMedianBlur(Image& image, int kernelSize, const Border& border) {
+    // 3x3 and 5x5 use sorting networks; larger kernels use sliding
+    // histograms whose cost per pixel is independent of kernelSize.
+    if (kernelSize < 1 || kernelSize % 2 == 0 || kernelSize > 255) {
+        std::cerr << "Median kernel size must be odd and between 1 and 255." << std::endl;
+        return;
+    }
+
+    const int w = image.w;
+    const int h = image.h;
+    const int c = image.channels;
+    const int r = kernelSize / 2;
+    unsigned char* data = image.data.get();
+    const std::vector<unsigned char> source(data, data + static_cast<size_t>(w) * h * c);
+
+    if (kernelSize == 3 || kernelSize == 5) {
+        #pragma omp parallel
+        {
+            std::vector<unsigned char> columns(kernelSize * (static_cast<size_t>(w + 2 * r) * c + MedianLanes));
+            auto row = kernelSize == 3 ? &medianNetworkRow<3> : &medianNetworkRow<5>;
+            #pragma omp for
+            for (int y = 0; y < h; ++y)
+                row(source.data(), data, w, h, c, y, border, columns);
+        }
+        return;
+    }
+
+    // The band plus its halo is padded with the border once
+    const int bands = MedianHistogram::bandCount(h, kernelSize);
+    #pragma omp parallel for
+    for (int b = 0; b < bands; ++b) {
+        const int y0 = h * b / bands;
+        const int y1 = h * (b + 1) / bands;
+        const size_t bandStride = static_cast<size_t>(w + 2 * r) * c;
+        std::vector<unsigned char> band(bandStride * (y1 - y0 + 2 * r));
+        copyWithBorder(source.data(), w, h, c, -r, w + r, y0 - r, y1 + r, border, band.data(), bandStride);
+        const unsigned char* planes[] = {band.data()};
+        for (int ch = 0; ch < c; ++ch)
+            MedianHistogram::band(planes, 1, c, ch, r, w, y1 - y0, data + static_cast<size_t>(y0) * w * c);
+    }
+}
+
+void Filter::applyConvolution(Image& image, const Kernel<int>& kernel, int divisor, int offset, const Border& border) {
+    if (!kernel.valid()) {
+        std::cerr << "Convolution kernel must be at least 1 x 1 with width * height weights." << std::endl;
+        return;
+    }
+    if (divisor == 0) {
+        std::cerr << "Convolution divisor must be non-zero." << std::endl;
+        return;
+    }
+    Image result(image.w, image.h, image.channels);
+    Convolution::apply(image, result, kernel, divisor, offset, border);
+    image.data = result.data;
+}
+
+void Filter::applyConvolution(Image& image, const Kernel<float>& kernel, float offset, const Border& border) {
+    if (!kernel.valid()) {
+        std::cerr << "Convolution kernel must be at least 1 x 1 with width * height weights." << std::endl;
+        return;
+    }
+    Image result(image.w, image.h, image.channels);
+    Convolution::apply(image, result, kernel, offset, border);
+    image.data = result.data;
+}
+
+void Filter::toGrayscalePlane(Image& image) {
+    if (image.channels >= 3) {
+        convertToGrayscale(image);
+    } else if (image.channels == 2) {
+        // Gray + alpha: keep the gray plane
+        Image gray(image.w, image.h, 1);
+        const unsigned char* src = image.data.get();
+        for (size_t i = 0; i < static_cast<size_t>(image.w) * image.h; ++i)
+            gray.data[i] = src[2 * i];
+        image.data = gray.data;
+        image.channels = 1;
+    }
+    image.size = static_cast<size_t>(image.w) * image.h;
+}
+
+void Filter::edgeDetection(Image& image, const std::vector<EdgeKernelType>& kernels, const Border& border,
+                           MagnitudeMode mode) {
+    toGrayscalePlane(image);
+    Image result(image.w, image.h, 1);
+    Gradient::chain(image.data.get(), image.w, image.h, kernels, border, mode, result.data.get());
+    image.data = result.data;
+}
+
+std::vector<Image> Filter::edgeDetectionAll(const Image& image, const std::vector<EdgeKernelType>& kernels,
+                                            const Border& border, MagnitudeMode mode) {
+    // The copy shares the pixels; the grayscale conversion replaces its buffer
+    Image gray = image;
+    toGrayscalePlane(gray);
+
+    std::vector<Image> results;
+    std::vector<Gradient::Output> outputs;
+    results.reserve(kernels.size());
+    for (EdgeKernelType kernel : kernels) {
+        results.emplace_back(gray.w, gray.h, 1);
+        outputs.push_back({kernel, nullptr, nullptr, results.back().data.get(), mode});
+    }
+    Gradient::compute(gray.data.get(), gray.w, gray.h, outputs, border);
+    return results;
+}
+
+void Filter::applyCanny(Image& image, int lowThreshold, int highThreshold, const Border& border) {
+    if (lowThreshold < 0 || highThreshold < lowThreshold) {
+        std::cerr << "Canny needs 0 <= low threshold <= high threshold." << std::endl;
+        return;
+    }
+    toGrayscalePlane(image);
+    Image result(image.w, image.h, 1);
+    Canny::detect(image.data.get(), image.w, image.h, lowThreshold, highThreshold, border, result.data.get());
+    image.data = result.data;
+}
 
+std::vector<float> Filter::cornerResponse(const Image& image, CornerType type, int windowRadius, float sigma,
+                                          EdgeKernelType gradient, float k, const Border& border) {
+    if (windowRadius < 0 || sigma < 0.0f) {
+        std::cerr << "Corner window needs a non-negative radius and sigma." << std::endl;
+        return {};
+    }
+    Image gray = image;
+    toGrayscalePlane(gray);
+
+    const std::vector<float> window = sigma > 0.0f ? createGaussianKernel(windowRadius, sigma)
+                                                   : std::vector<float>(2 * windowRadius + 1, 1.0f / (2 * windowRadius + 1));
+    std::vector<float> response(static_cast<size_t>(gray.w) * gray.h);
+    Corners::response(gray.data.get(), gray.w, gray.h, type, gradient, window, k, border, response.data());
+    return response;
+}
 
+std::vector<Keypoint> Filter::detectCorners(const Image& image, CornerType type, float threshold, int maxCorners,
+                                            int suppressionRadius) {
+    const std::vector<float> response = cornerResponse(image, type);
+    return Corners::keypoints(response.data(), image.w, image.h, threshold, suppressionRadius, maxCorners);
+}
@@ -1,6 +1,11 @@
 #pragma once
 #include "Image.h"
+#include "Border.h"
+#include "Convolution.h"
+#include "Gradient.h"
+#include "Corners.h"
 #include <cmath> // For round()
+#include <vector>
 
 class Filter {
 public:
@@ -23,24 +28,57 @@ public:
     void addSaltAndPepperNoise(Image& image, float saltProbability, float pepperProbability);
 
     // blur
-    // static std::vector<std::vector<float>> createGaussianKernel(int radius, float sigma);
-    // void applyGaussianBlur(Image& image, int radius, float sigma);
-    // void applyMedianBlur(Image& image, int kernelSize);
-    // void applyBoxBlur(Image& image, int kernelSize);
-    
+    static const std::vector<float>& createGaussianKernel(int radius, float sigma);
+    // The same weights in 8.8 fixed point, summing to exactly 256; empty if
+    // 8 fractional bits cannot represent them (very wide, flat kernels)
+    static const std::vector<uint16_t>& createFixedPointGaussianKernel(int radius, float sigma);
+    void applyGaussianBlur(Image& image, int radius, float sigma = 1.0f, const Border& border = Border());
+    // From this sigma upwards applyGaussianBlur uses the recursive backend,
+    // provided the border is Clamp or Constant and radius is at least
+    // RecursiveGaussianSpan * sigma, so both backends blur with the same
+    // (untruncated) Gaussian. Shorter radii keep the truncated FIR kernel.
+    static constexpr float RecursiveGaussianSigma = 4.0f;
+    static constexpr float RecursiveGaussianSpan = 3.0f;
+    void applyMedianBlur(Image& image, int kernelSize, const Border& border = Border());
+    void applyBoxBlur(Image& image, int kernelSize, const Border& border = Border());
 
-    // // edge detection
-    // enum class EdgeKernelType { Sobel, Prewitt, Scharr, Robert };
-    // void edgeDetection(Image& image, const std::vector<EdgeKernelType>& kernels);
+    // generic convolution, e.g. for kernels without a dedicated filter
+    void applyConvolution(Image& image, const Kernel<int>& kernel, int divisor = 1, int offset = 0,
+                          const Border& border = Border());
+    void applyConvolution(Image& image, const Kernel<float>& kernel, float offset = 0.0f,
+                          const Border& border = Border());
+
+
+    // edge detection: the image becomes the gradient magnitude of its
+    // grayscale version; each kernel in turn is applied to the previous result
+    using EdgeKernelType = ::EdgeKernelType;
+    using MagnitudeMode = ::MagnitudeMode;
+    void edgeDetection(Image& image, const std::vector<EdgeKernelType>& kernels, const Border& border = Border(),
+                       MagnitudeMode mode = MagnitudeMode::Exact);
+    // All kernels on the same input in a single pass, one magnitude image each
+    std::vector<Image> edgeDetectionAll(const Image& image, const std::vector<EdgeKernelType>& kernels,
+                                        const Border& border = Border(), MagnitudeMode mode = MagnitudeMode::Exact);
+    // Canny edges (0 or 255) of the grayscale image; thresholds on the Sobel
+    // magnitude, smoothing is up to the caller
+    void applyCanny(Image& image, int lowThreshold, int highThreshold, const Border& border = Border());
+
+    // corners: response map (w x h) of the grayscale image, with the
+    // structure tensor summed over a Gaussian window of the given radius, or
+    // a box window when sigma is 0. Gradients are scaled so a black-to-white
+    // step is 1.
+    using CornerType = ::CornerType;
+    std::vector<float> cornerResponse(const Image& image, CornerType type, int windowRadius = 2, float sigma = 1.0f,
+                                      EdgeKernelType gradient = EdgeKernelType::Sobel, float k = 0.04f,
+                                      const Border& border = Border());
+    // Local maxima of the default response above threshold, strongest first
+    std::vector<Keypoint> detectCorners(const Image& image, CornerType type, float threshold, int maxCorners = 0,
+                                        int suppressionRadius = 3);
 
 
 private:
-    static const int SobelX[3][3];
-    static const int SobelY[3][3];
-    static const int PrewittX[3][3];
-    static const int PrewittY[3][3];
-    static const int ScharrX[3][3];
-    static const int ScharrY[3][3];
-    static const int RobertX[2][2];
-    static const int RobertY[2][2];
+    // blur backends
+    void applyRecursiveGaussian(Image& image, float sigma, const Border& border);
+
+    // edge detection input: a single gray plane
+    void toGrayscalePlane(Image& image);
 };
\ No newline at end of file
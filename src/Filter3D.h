@@ -0,0 +1,58 @@
+#pragma once
+#include "Border.h"
+#include "Volume.h"
+#include "BrickedVolume.h"
+#include <functional>
+
+enum class VolumeFilterType { Gaussian, Median };
+
+// A 3D filter and its parameters, e.g. {VolumeFilterType::Median, 5} for a
+// 5x5x5 median
+struct VolumeFilter {
+    VolumeFilterType type;
+    int size;     // odd kernel size along each axis
+    float sigma;  // Gaussian only
+    Border border;
+
+    VolumeFilter(VolumeFilterType _type, int _size, float _sigma = 1.0f, const Border& _border = Border())
+        : type(_type), size(_size), sigma(_sigma), border(_border) {}
+};
+
+// Filters over the voxels of a stack of slices. Every filter runs along z
+// one output slice at a time, from a rolling window of the input slices it
+// reaches, so besides the input only that window is ever held in memory.
+class Filter3D {
+public:
+    // Input slice z (w x h bytes); the pointer must stay valid until the next call
+    using SliceSource = std::function<const unsigned char*(int z)>;
+    // Output slice z, delivered in increasing z; the buffer is reused afterwards
+    using SliceSink = std::function<void(int z, const unsigned char* slice)>;
+
+    // Separable Gaussian over a (2 radius + 1)^3 neighbourhood, in place. The
+    // border applies on all six faces of the volume.
+    void applyGaussianBlur(Volume& volume, int radius, float sigma = 1.0f, const Border& border = Border());
+    // In place on a bricked volume: slices stream through its brick cache
+    // and are written back as soon as they are filtered
+    void applyGaussianBlur(BrickedVolume& volume, int radius, float sigma = 1.0f, const Border& border = Border());
+    // The same filter streamed from source to sink over a w x h x d stack,
+    // for output slices [first, last] (last = -1 for the final slice). The
+    // slices the z border mirrors in are read first, the rest in increasing
+    // z, each before the output slice of the same z is sunk. A sink may
+    // therefore overwrite the source in place.
+    void gaussianBlur(int w, int h, int d, int radius, float sigma, const Border& border, const SliceSource& source,
+                      const SliceSink& sink, int first = 0, int last = -1);
+
+    // Median over a kernelSize^3 neighbourhood (odd, 1 to MaxMedianSize), in
+    // place. 3x3x3 uses a sorting network, larger sizes sliding histograms.
+    static constexpr int MaxMedianSize = 39;
+    void applyMedianBlur(Volume& volume, int kernelSize, const Border& border = Border());
+    void applyMedianBlur(BrickedVolume& volume, int kernelSize, const Border& border = Border());
+    // The same filter streamed from source to sink, read like gaussianBlur
+    void medianBlur(int w, int h, int d, int kernelSize, const Border& border, const SliceSource& source,
+                    const SliceSink& sink, int first = 0, int last = -1);
+
+    // Either filter, as described by a VolumeFilter (size = 2 radius + 1 for
+    // the Gaussian), streamed like the above
+    void filter(const VolumeFilter& filter, int w, int h, int d, const SliceSource& source, const SliceSink& sink,
+                int first = 0, int last = -1);
+};
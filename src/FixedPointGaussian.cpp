@@ -0,0 +1,79 @@
+#include "FixedPointGaussian.h"
+#include <algorithm>
+
+namespace FixedPointGaussian {
+
+void rows(const unsigned char* src, int w, int h, int channels, const std::vector<uint16_t>& kernel,
+          const Border& border, uint16_t* dst) {
+    const int size = static_cast<int>(kernel.size());
+    const int radius = size / 2;
+    const int rowLen = w * channels;
+
+    #pragma omp parallel
+    {
+        std::vector<unsigned char> padded(static_cast<size_t>(w + 2 * radius) * channels);
+
+        #pragma omp for
+        for (int y = 0; y < h; ++y) {
+            copyWithBorder(src, w, h, channels, -radius, w + radius, y, y + 1, border, padded.data(), padded.size());
+
+            uint16_t* out = dst + static_cast<size_t>(y) * rowLen;
+            std::fill(out, out + rowLen, 0);
+            for (int t = 0; t < size; ++t) {
+                const uint16_t weight = kernel[t];
+                const unsigned char* tap = padded.data() + t * channels;
+                #pragma omp simd
+                for (int i = 0; i < rowLen; ++i)
+                    out[i] += weight * tap[i];
+            }
+        }
+    }
+}
+
+template <typename Out>
+void sumTaps(const uint16_t* const* taps, size_t offset, int n, const std::vector<uint16_t>& kernel, uint32_t* acc,
+             Out* out) {
+    // Fractional bits to drop: all 16 for bytes, 8 for another pass
+    constexpr int shift = 8 * (3 - static_cast<int>(sizeof(Out)));
+    std::fill(acc, acc + n, 0);
+    for (size_t t = 0; t < kernel.size(); ++t) {
+        const uint32_t weight = kernel[t];
+        const uint16_t* tap = taps[t] + offset;
+        #pragma omp simd
+        for (int i = 0; i < n; ++i)
+            acc[i] += weight * tap[i];
+    }
+    #pragma omp simd
+    for (int i = 0; i < n; ++i)
+        out[i] = static_cast<Out>(acc[i] >> shift);
+}
+
+template <typename Out>
+void columns(const uint16_t* src, int rowLen, int h, const std::vector<uint16_t>& kernel, const Border& border,
+             Out* dst) {
+    const int radius = static_cast<int>(kernel.size()) / 2;
+
+    // Rows -radius .. h + radius - 1 of the horizontal result
+    const std::vector<uint16_t> constantRow(rowLen, static_cast<uint16_t>(border.value * 256));
+    std::vector<const uint16_t*> taps(h + 2 * radius);
+    for (int y = -radius; y < h + radius; ++y) {
+        const int sy = borderIndex(y, h, border.mode);
+        taps[y + radius] = sy < 0 ? constantRow.data() : src + static_cast<size_t>(sy) * rowLen;
+    }
+
+    #pragma omp parallel
+    {
+        std::vector<uint32_t> acc(rowLen);
+
+        #pragma omp for
+        for (int y = 0; y < h; ++y)
+            sumTaps(taps.data() + y, 0, rowLen, kernel, acc.data(), dst + static_cast<size_t>(y) * rowLen);
+    }
+}
+
+template void sumTaps(const uint16_t* const*, size_t, int, const std::vector<uint16_t>&, uint32_t*, unsigned char*);
+template void sumTaps(const uint16_t* const*, size_t, int, const std::vector<uint16_t>&, uint32_t*, uint16_t*);
+template void columns(const uint16_t*, int, int, const std::vector<uint16_t>&, const Border&, unsigned char*);
+template void columns(const uint16_t*, int, int, const std::vector<uint16_t>&, const Border&, uint16_t*);
+
+} // namespace FixedPointGaussian
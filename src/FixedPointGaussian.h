@@ -0,0 +1,34 @@
+#pragma once
+#include "Border.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The separable passes of the fixed-point Gaussian, shared by the 2D blur
+// and the x, y and z passes of the 3D blur. kernel holds the 8.8 weights of
+// Filter::createFixedPointGaussianKernel, which sum to 256. Taps are the
+// outer loop everywhere, so each step is a row-wide multiply-add.
+namespace FixedPointGaussian {
+
+// Horizontal pass over a w x h image of `channels` interleaved values: dst
+// (w * channels x h) keeps 8 fractional bits. Each row is padded with the
+// border so the tap loop runs without bounds checks.
+void rows(const unsigned char* src, int w, int h, int channels, const std::vector<uint16_t>& kernel,
+          const Border& border, uint16_t* dst);
+
+// kernel[t] * taps[t][offset + x] summed over the kernel for x < n, from
+// values with 8 fractional bits. unsigned char output truncates all 16
+// fractional bits of the sum; uint16_t output keeps 8 for a further pass.
+// acc is scratch for n values.
+template <typename Out>
+void sumTaps(const uint16_t* const* taps, size_t offset, int n, const std::vector<uint16_t>& kernel, uint32_t* acc,
+             Out* out);
+
+// Vertical pass over the result of rows (rowLen x h) into dst. Rows beyond
+// the top and bottom follow the border; a Constant border is its value in
+// the same fixed point.
+template <typename Out>
+void columns(const uint16_t* src, int rowLen, int h, const std::vector<uint16_t>& kernel, const Border& border,
+             Out* dst);
+
+} // namespace FixedPointGaussian
@@ -0,0 +1,65 @@
+#pragma once
+#include "Border.h"
+#include <cstdint>
+#include <vector>
+
+enum class EdgeKernelType { Sobel, Prewitt, Scharr, Robert };
+
+// How the gradient magnitude is formed from Gx and Gy. Against the exact
+// floor(sqrt(gx^2 + gy^2)) over all |gx|, |gy| <= 256 (output saturated at
+// 255), and relative to a double sqrt per pixel on a 4000x3000 image:
+//   Exact            bit-exact                           ~1.1x (SSE2), ~4.3x (AVX2)
+//   L1               |gx| + |gy|: max error 75, mean 24  ~4x, ~20x
+//   AlphaMaxBetaMin  max error 10, mean 3.2              ~1.8x, ~9x
+enum class MagnitudeMode { Exact, L1, AlphaMaxBetaMin };
+
+namespace Gradient {
+
+// The operators' kernels, anchored like Kernel. horizontalPass takes its
+// taps from these at compile time, so zero taps and unit weights fold away.
+inline constexpr int SobelX[3][3] = {{-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1}};
+inline constexpr int SobelY[3][3] = {{-1, -2, -1}, {0, 0, 0}, {1, 2, 1}};
+inline constexpr int PrewittX[3][3] = {{-1, 0, 1}, {-1, 0, 1}, {-1, 0, 1}};
+inline constexpr int PrewittY[3][3] = {{-1, -1, -1}, {0, 0, 0}, {1, 1, 1}};
+inline constexpr int ScharrX[3][3] = {{-3, 0, 3}, {-10, 0, 10}, {-3, 0, 3}};
+inline constexpr int ScharrY[3][3] = {{-3, -10, -3}, {0, 0, 0}, {3, 10, 3}};
+inline constexpr int RobertX[2][2] = {{1, 0}, {0, -1}};
+inline constexpr int RobertY[2][2] = {{0, 1}, {-1, 0}};
+
+// Rows per parallel band; each band is padded with a one pixel halo once
+constexpr int BandRows = 64;
+
+// Destination of one operator's results. gx, gy and magnitude are w x h and
+// any of them may be null. The magnitude is saturated at 255.
+struct Output {
+    EdgeKernelType type;
+    int16_t* gx;
+    int16_t* gy;
+    unsigned char* magnitude;
+    MagnitudeMode mode = MagnitudeMode::Exact;
+};
+
+// Gradients of a single-channel w x h image. Sobel, Prewitt and Scharr are
+// separable into a [-1, 0, 1] derivative and a 3-tap smoothing ([1, 2, 1],
+// [1, 1, 1], [3, 10, 3]), so each output row is two 1D passes over the same
+// three input rows: a vertical pass giving the row sums and differences,
+// then a horizontal pass giving Gx, Gy and the magnitude. Roberts Cross is a
+// 2x2 difference anchored at the top-left pixel.
+//
+// All outputs are produced in one pass over the image: the vertical pass is
+// shared and each band is read once while it is cache resident.
+void compute(const unsigned char* src, int w, int h, const std::vector<Output>& outputs, const Border& border);
+
+// Single operator shorthand
+void compute(const unsigned char* src, int w, int h, EdgeKernelType type, const Border& border,
+             int16_t* gx, int16_t* gy, unsigned char* magnitude, MagnitudeMode mode = MagnitudeMode::Exact);
+
+// Magnitude of kernels[0], then of kernels[1] on that result, and so on,
+// into dst (w x h). Each band goes through every stage in two band-sized
+// ping-pong buffers, recomputing the rows later stages reach into its
+// neighbours, so the image is read and written once whatever the number of
+// kernels and peak memory stays at one output plus two bands per thread.
+void chain(const unsigned char* src, int w, int h, const std::vector<EdgeKernelType>& kernels, const Border& border,
+           MagnitudeMode mode, unsigned char* dst);
+
+} // namespace Gradient
@@ -0,0 +1,112 @@
+#include "IntegralImage.h"
+#include <algorithm>
+
+template <typename T>
+IntegralImage<T>::IntegralImage(const Image& image, int channel, bool withSquares)
+    : w(image.w), h(image.h) {
+    if (channel < 0 || channel >= image.channels) {
+        std::cerr << "Channel " << channel << " out of range, using channel 0." << std::endl;
+        channel = 0;
+    }
+    build(table, image.data.get(), w, h, image.channels, channel, false);
+    if (withSquares)
+        build(squares, image.data.get(), w, h, image.channels, channel, true);
+}
+
+template <typename T>
+void IntegralImage<T>::build(std::vector<T>& t, const unsigned char* data, int w, int h, int channels, int channel, bool square) {
+    const size_t stride = static_cast<size_t>(w) + 1;
+    t.assign(stride * (h + 1), 0);
+
+    // Pass 1: prefix sum along each row, rows in parallel
+    #pragma omp parallel for
+    for (int y = 0; y < h; ++y) {
+        const unsigned char* src = data + static_cast<size_t>(y) * w * channels + channel;
+        T* dst = t.data() + (y + 1) * stride + 1;
+        T running = 0;
+        for (int x = 0; x < w; ++x) {
+            T v = src[x * channels];
+            running += square ? v * v : v;
+            dst[x] = running;
+        }
+    }
+
+    // Pass 2: prefix sum down the columns. Each block of columns is swept top
+    // to bottom a whole row segment at a time, which vectorises and keeps the
+    // blocks independent for parallel execution.
+    const int blockWidth = 1024;
+    #pragma omp parallel for
+    for (int x0 = 1; x0 <= w; x0 += blockWidth) {
+        const int x1 = std::min(x0 + blockWidth, w + 1);
+        for (int y = 2; y <= h; ++y) {
+            const T* above = t.data() + (y - 1) * stride;
+            T* row = t.data() + y * stride;
+            #pragma omp simd
+            for (int x = x0; x < x1; ++x)
+                row[x] += above[x];
+        }
+    }
+}
+
+template <typename T>
+T IntegralImage<T>::sumSquares(int x0, int y0, int x1, int y1) const {
+    if (!hasSquares()) {
+        std::cerr << "Sums of squares require an integral image built with squares." << std::endl;
+        return 0;
+    }
+    return rectSum(squares, x0, y0, x1, y1);
+}
+
+template <typename T>
+double IntegralImage<T>::mean(int x0, int y0, int x1, int y1) const {
+    const double area = static_cast<double>(x1 - x0) * (y1 - y0);
+    return area > 0 ? sum(x0, y0, x1, y1) / area : 0.0;
+}
+
+template <typename T>
+double IntegralImage<T>::variance(int x0, int y0, int x1, int y1) const {
+    if (!hasSquares()) {
+        std::cerr << "Variance requires an integral image built with squares." << std::endl;
+        return 0.0;
+    }
+    const double area = static_cast<double>(x1 - x0) * (y1 - y0);
+    if (area <= 0)
+        return 0.0;
+    const double m = sum(x0, y0, x1, y1) / area;
+    return std::max(0.0, sumSquares(x0, y0, x1, y1) / area - m * m);
+}
+
+template <typename T>
+void IntegralImage<T>::sums(const std::vector<Rect>& rects, std::vector<T>& out) const {
+    out.resize(rects.size());
+    const long n = static_cast<long>(rects.size());
+    #pragma omp parallel for if (n > 4096)
+    for (long i = 0; i < n; ++i)
+        out[i] = sum(rects[i].x0, rects[i].y0, rects[i].x1, rects[i].y1);
+}
+
+template <typename T>
+void IntegralImage<T>::means(const std::vector<Rect>& rects, std::vector<double>& out) const {
+    out.resize(rects.size());
+    const long n = static_cast<long>(rects.size());
+    #pragma omp parallel for if (n > 4096)
+    for (long i = 0; i < n; ++i)
+        out[i] = mean(rects[i].x0, rects[i].y0, rects[i].x1, rects[i].y1);
+}
+
+template <typename T>
+void IntegralImage<T>::variances(const std::vector<Rect>& rects, std::vector<double>& out) const {
+    out.resize(rects.size());
+    if (!hasSquares()) {
+        std::cerr << "Variance requires an integral image built with squares." << std::endl;
+        std::fill(out.begin(), out.end(), 0.0);
+        return;
+    }
+    const long n = static_cast<long>(rects.size());
+    #pragma omp parallel for if (n > 4096)
+    for (long i = 0; i < n; ++i)
+        out[i] = variance(rects[i].x0, rects[i].y0, rects[i].x1, rects[i].y1);
+}
+
+template class IntegralImage<uint32_t>;
+template class IntegralImage<uint64_t>;
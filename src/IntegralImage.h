@@ -0,0 +1,52 @@
+#pragma once
+#include "Image.h"
+#include <cstdint>
+#include <vector>
+
+// Summed-area table over one channel of an Image.
+//
+// The table carries an extra zero row and column, so the sum over any
+// half-open rectangle [x0, x1) x [y0, y1) is four lookups. Accumulation is
+// unsigned and wraps, which means a 32-bit table still gives exact results
+// for every rectangle whose own sum fits in 32 bits, however large the image.
+template <typename T>
+class IntegralImage {
+public:
+    struct Rect {
+        int x0, y0, x1, y1;
+    };
+
+    // withSquares also builds a table of squared values for variance queries
+    IntegralImage(const Image& image, int channel = 0, bool withSquares = false);
+
+    int width() const { return w; }
+    int height() const { return h; }
+    bool hasSquares() const { return !squares.empty(); }
+
+    T sum(int x0, int y0, int x1, int y1) const { return rectSum(table, x0, y0, x1, y1); }
+    // Needs a table built withSquares; 0 otherwise
+    T sumSquares(int x0, int y0, int x1, int y1) const;
+    double mean(int x0, int y0, int x1, int y1) const;
+    double variance(int x0, int y0, int x1, int y1) const;
+
+    // Batched queries, evaluated in parallel for large batches
+    void sums(const std::vector<Rect>& rects, std::vector<T>& out) const;
+    void means(const std::vector<Rect>& rects, std::vector<double>& out) const;
+    void variances(const std::vector<Rect>& rects, std::vector<double>& out) const;
+
+private:
+    int w;
+    int h;
+    std::vector<T> table;   // (w + 1) * (h + 1), row-major
+    std::vector<T> squares; // same layout, empty unless requested
+
+    T rectSum(const std::vector<T>& t, int x0, int y0, int x1, int y1) const {
+        const size_t stride = static_cast<size_t>(w) + 1;
+        return t[y1 * stride + x1] - t[y0 * stride + x1] - t[y1 * stride + x0] + t[y0 * stride + x0];
+    }
+
+    static void build(std::vector<T>& t, const unsigned char* data, int w, int h, int channels, int channel, bool square);
+};
+
+using IntegralImage32 = IntegralImage<uint32_t>;
+using IntegralImage64 = IntegralImage<uint64_t>;
@@ -0,0 +1,83 @@
+#include "MedianHistogram.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace MedianHistogram {
+
+int bandCount(int h, int kernelSize) {
+    int bands = 1;
+#ifdef _OPENMP
+    bands = std::max(1, std::min(omp_get_max_threads(), h / (4 * kernelSize)));
+#endif
+    return bands;
+}
+
+void band(const unsigned char* const* planes, int planeCount, int channels, int channel, int r, int w, int rows,
+          unsigned char* dst) {
+    const int size = 2 * r + 1;
+    const int rank = size * size * planeCount / 2;
+    const int paddedW = w + 2 * r;
+    const size_t bandStride = static_cast<size_t>(paddedW) * channels;
+    std::vector<uint16_t> colFine(static_cast<size_t>(paddedW) * 256, 0);
+    std::vector<uint16_t> colCoarse(static_cast<size_t>(paddedW) * 16, 0);
+    auto addRow = [&](int y, int delta) {
+        for (int k = 0; k < planeCount; ++k) {
+            const unsigned char* row = planes[k] + y * bandStride + channel;
+            for (int x = 0; x < paddedW; ++x) {
+                const unsigned char v = row[x * channels];
+                colFine[x * 256 + v] += delta;
+                colCoarse[x * 16 + (v >> 4)] += delta;
+            }
+        }
+    };
+
+    for (int j = 0; j < size; ++j)
+        addRow(j, 1);
+
+    uint16_t kernelFine[256];
+    uint16_t kernelCoarse[16];
+    auto addColumn = [&](int x, int times) {
+        const uint16_t* fine = colFine.data() + x * 256;
+        const uint16_t* coarse = colCoarse.data() + x * 16;
+        #pragma omp simd
+        for (int i = 0; i < 256; ++i)
+            kernelFine[i] += times * fine[i];
+        for (int i = 0; i < 16; ++i)
+            kernelCoarse[i] += times * coarse[i];
+    };
+
+    for (int y = 0; y < rows; ++y) {
+        if (y > 0) {
+            addRow(y - 1, -1);
+            addRow(y + 2 * r, 1);
+        }
+
+        std::fill(kernelFine, kernelFine + 256, 0);
+        std::fill(kernelCoarse, kernelCoarse + 16, 0);
+        for (int i = 0; i < size; ++i)
+            addColumn(i, 1);
+
+        unsigned char* out = dst + static_cast<size_t>(y) * w * channels + channel;
+        for (int x = 0; x < w; ++x) {
+            if (x > 0) {
+                addColumn(x + 2 * r, 1);
+                addColumn(x - 1, -1);
+            }
+
+            int below = 0;
+            int bin = 0;
+            while (below + kernelCoarse[bin] <= rank)
+                below += kernelCoarse[bin++];
+            int value = bin * 16;
+            while (below + kernelFine[value] <= rank)
+                below += kernelFine[value++];
+            out[x * channels] = static_cast<unsigned char>(value);
+        }
+    }
+}
+
+} // namespace MedianHistogram
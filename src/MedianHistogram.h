@@ -0,0 +1,25 @@
+#pragma once
+
+// Large medians by Perreault & Hebert (2007) constant-time histograms,
+// shared by the 2D median and its 3D extension.
+namespace MedianHistogram {
+
+// Bands for an image h rows tall. Each band rebuilds its column histograms
+// from scratch, so split into no more bands than threads and keep them tall
+// relative to the kernel.
+int bandCount(int h, int kernelSize);
+
+// Median over (2r + 1)^2 pixels of planeCount planes, for one channel of a
+// band of rows. planes holds one band per plane, each already padded by r
+// on every side ((w + 2r) x (rows + 2r) pixels of `channels` interleaved
+// values), so no index is ever clamped. Every column keeps a histogram of
+// the pixels it spans above and below the current row in all planes; moving
+// down a row updates it by one row of every plane out and one in. Along the
+// row the kernel histogram gains the column entering the window and loses
+// the one leaving it. Both levels of histogram are kept: 16 coarse bins to
+// find the right range quickly, then 256 fine bins for the exact value.
+// dst receives rows x w pixels of `channels` values, written at `channel`.
+void band(const unsigned char* const* planes, int planeCount, int channels, int channel, int r, int w, int rows,
+          unsigned char* dst);
+
+} // namespace MedianHistogram
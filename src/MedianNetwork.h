@@ -0,0 +1,48 @@
+#pragma once
+#include <algorithm>
+
+// Small medians with branchless min/max networks. Every compare-exchange
+// works on a block of Lanes neighbouring bytes at once, which the compiler
+// turns into vector min/max instructions.
+namespace MedianNetwork {
+
+constexpr int Lanes = 32;
+
+inline void sortLanes(unsigned char* a, unsigned char* b, int n = Lanes) {
+    #pragma omp simd
+    for (int l = 0; l < n; ++l) {
+        const unsigned char lo = std::min(a[l], b[l]);
+        b[l] = std::max(a[l], b[l]);
+        a[l] = lo;
+    }
+}
+
+// Optimal 5-input sorting network (9 compare-exchanges)
+inline void sort5Lanes(unsigned char* v[5], int n = Lanes) {
+    sortLanes(v[0], v[1], n); sortLanes(v[3], v[4], n); sortLanes(v[2], v[4], n);
+    sortLanes(v[2], v[3], n); sortLanes(v[0], v[3], n); sortLanes(v[0], v[2], n);
+    sortLanes(v[1], v[4], n); sortLanes(v[1], v[3], n); sortLanes(v[1], v[2], n);
+}
+
+// Forgetful selection (Paeth): hold N / 2 + 2 values, drop the minimum and
+// maximum, which cannot be the median, pull in the next value, and repeat.
+// Returns the lane block holding the median.
+template <int N>
+unsigned char* forgetfulMedianLanes(unsigned char* v[N], int n = Lanes) {
+    int lo = 0;
+    int hi = N / 2 + 2;
+    int next = hi;
+    while (true) {
+        for (int i = lo + 1; i < hi; ++i)
+            sortLanes(v[lo], v[i], n);
+        for (int i = lo + 1; i < hi - 1; ++i)
+            sortLanes(v[i], v[hi - 1], n);
+        ++lo;
+        --hi;
+        if (next == N)
+            return v[lo];
+        v[hi++] = v[next++];
+    }
+}
+
+} // namespace MedianNetwork
@@ -0,0 +1,431 @@
+#include "Projection.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Running per-pixel state of a set of projections over slices of n pixels.
+// Only the state the requested types need is kept: the extremes as bytes,
+// sums in 32 bits and sums of squares in 64 bits.
+struct Accumulator {
+    std::vector<unsigned char> maximum;
+    std::vector<unsigned char> minimum;
+    std::vector<uint32_t> sum;
+    std::vector<uint64_t> squares;
+
+    Accumulator(const std::vector<ProjectionType>& types, size_t n) {
+        for (ProjectionType type : types) {
+            if (type == ProjectionType::Maximum)
+                maximum.assign(n, 0);
+            else if (type == ProjectionType::Minimum)
+                minimum.assign(n, 255);
+            else
+                sum.assign(n, 0);
+            if (type == ProjectionType::StandardDeviation)
+                squares.assign(n, 0);
+        }
+    }
+
+    // Folds n pixels of a slice into pixels [offset, offset + n). The row is
+    // read from memory once and stays in L1 for the other states.
+    void fold(const unsigned char* src, size_t offset, size_t n) {
+        if (!maximum.empty()) {
+            unsigned char* acc = maximum.data() + offset;
+            #pragma omp simd
+            for (size_t i = 0; i < n; ++i)
+                acc[i] = std::max(acc[i], src[i]);
+        }
+        if (!minimum.empty()) {
+            unsigned char* acc = minimum.data() + offset;
+            #pragma omp simd
+            for (size_t i = 0; i < n; ++i)
+                acc[i] = std::min(acc[i], src[i]);
+        }
+        if (!sum.empty()) {
+            uint32_t* acc = sum.data() + offset;
+            #pragma omp simd
+            for (size_t i = 0; i < n; ++i)
+                acc[i] += src[i];
+        }
+        if (!squares.empty()) {
+            uint64_t* acc = squares.data() + offset;
+            #pragma omp simd
+            for (size_t i = 0; i < n; ++i)
+                acc[i] += static_cast<uint32_t>(src[i] * src[i]);
+        }
+    }
+
+    // Combines a partial result over other slices
+    void merge(const Accumulator& other) {
+        if (!maximum.empty())
+            for (size_t i = 0; i < maximum.size(); ++i)
+                maximum[i] = std::max(maximum[i], other.maximum[i]);
+        if (!minimum.empty())
+            for (size_t i = 0; i < minimum.size(); ++i)
+                minimum[i] = std::min(minimum[i], other.minimum[i]);
+        for (size_t i = 0; i < sum.size(); ++i)
+            sum[i] += other.sum[i];
+        for (size_t i = 0; i < squares.size(); ++i)
+            squares[i] += other.squares[i];
+    }
+
+    // One projection of `count` folded slices
+    void store(ProjectionType type, unsigned char* out, int count) const {
+        switch (type) {
+            case ProjectionType::Maximum:
+                std::memcpy(out, maximum.data(), maximum.size());
+                break;
+            case ProjectionType::Minimum:
+                std::memcpy(out, minimum.data(), minimum.size());
+                break;
+            case ProjectionType::Average:
+                for (size_t i = 0; i < sum.size(); ++i)
+                    out[i] = static_cast<unsigned char>(sum[i] / count);
+                break;
+            case ProjectionType::StandardDeviation:
+                // Population deviation from integer moments: n^2 var = n sq - s^2
+                for (size_t i = 0; i < sum.size(); ++i) {
+                    const double s = sum[i];
+                    const double spread = static_cast<double>(count) * squares[i] - s * s;
+                    out[i] = static_cast<unsigned char>(std::sqrt(std::max(spread, 0.0)) / count);
+                }
+                break;
+        }
+    }
+};
+
+// Resolves [first, last] against depth d, last = -1 meaning the final slice
+bool slabRange(int d, int first, int& last) {
+    if (last < 0)
+        last = d - 1;
+    if (first < 0 || first > last || last >= d) {
+        std::cerr << "Slab [" << first << ", " << last << "] is outside the " << d << " slices." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// One image per type, in the order given
+std::vector<Image> results(const Accumulator& acc, const std::vector<ProjectionType>& types, int w, int h, int count) {
+    std::vector<Image> images;
+    images.reserve(types.size());
+    for (ProjectionType type : types) {
+        images.emplace_back(w, h, 1);
+        acc.store(type, images.back().data.get(), count);
+    }
+    return images;
+}
+
+// Folds a whole w x h slice, rows in parallel
+void foldSlice(Accumulator& acc, const unsigned char* slice, int w, int h) {
+    #pragma omp parallel for schedule(dynamic, 8)
+    for (int y = 0; y < h; ++y) {
+        const size_t offset = static_cast<size_t>(y) * w;
+        acc.fold(slice + offset, offset, w);
+    }
+}
+
+// Projections of output slices [first, last] of a 3D filter over a w x h x d
+// stack, folded as the filter delivers them
+std::vector<Image> foldFiltered(const std::vector<ProjectionType>& types, const VolumeFilter& filter, int w, int h,
+                                int d, const Filter3D::SliceSource& source, int first, int last) {
+    Accumulator acc(types, static_cast<size_t>(w) * h);
+    int folded = 0;
+    Filter3D filter3D;
+    filter3D.filter(filter, w, h, d, source,
+                    [&](int, const unsigned char* slice) {
+                        foldSlice(acc, slice, w, h);
+                        ++folded;
+                    },
+                    first, last);
+    // The filter reports its own errors and then delivers no slices
+    if (folded != last - first + 1)
+        return std::vector<Image>(types.size(), Image(0, 0, 1));
+
+    return results(acc, types, w, h, folded);
+}
+
+// Running extremes of every window [z, z + k), z = 0 .. d - k. The stack is
+// cut into blocks of k slices; a window starting at offset j of a block is
+// the suffix of that block from j combined with the prefix of the next block
+// up to j - 1, so one block of suffixes and one running prefix suffice.
+template <typename Pick>
+void slidingExtremum(const Volume& volume, int k, Pick pick, const std::function<void(int, const Image&)>& sink) {
+    const int w = volume.w;
+    const int h = volume.h;
+    const size_t n = static_cast<size_t>(w) * h;
+    const int final = volume.d - k;
+    std::vector<unsigned char> suffix(static_cast<size_t>(k) * n);
+    std::vector<unsigned char> prefix(n);
+
+    // Blocks starting past the final window are never needed, so every block
+    // used lies wholly inside the stack
+    for (int start = 0; start <= final; start += k) {
+        #pragma omp parallel for schedule(dynamic, 8)
+        for (int y = 0; y < h; ++y) {
+            const size_t offset = static_cast<size_t>(y) * w;
+            unsigned char* next = suffix.data() + (k - 1) * n + offset;
+            std::memcpy(next, volume.slice(start + k - 1) + offset, w);
+            for (int j = k - 2; j >= 0; --j) {
+                unsigned char* acc = next - n;
+                const unsigned char* src = volume.slice(start + j) + offset;
+                #pragma omp simd
+                for (int x = 0; x < w; ++x)
+                    acc[x] = pick(src[x], next[x]);
+                next = acc;
+            }
+        }
+
+        const int count = std::min(k, final - start + 1);
+        for (int j = 0; j < count; ++j) {
+            Image image(w, h, 1);
+            unsigned char* out = image.data.get();
+            if (j == 0) {
+                // The window is exactly this block
+                std::memcpy(out, suffix.data(), n);
+            } else {
+                // The next block's prefix starts at its first slice
+                const unsigned char* src = volume.slice(start + k + j - 1);
+                const unsigned char* tail = suffix.data() + j * n;
+                unsigned char* head = prefix.data();
+                if (j == 1)
+                    std::memcpy(head, src, n);
+                #pragma omp parallel for simd
+                for (size_t i = 0; i < n; ++i) {
+                    head[i] = pick(head[i], src[i]);
+                    out[i] = pick(tail[i], head[i]);
+                }
+            }
+            sink(start + j, image);
+        }
+    }
+}
+
+} // namespace
+
+Image Projection::project(const Volume& volume, ProjectionType type, int first, int last) {
+    return project(volume, std::vector<ProjectionType>{type}, first, last)[0];
+}
+
+std::vector<Image> Projection::project(const Volume& volume, const std::vector<ProjectionType>& types, int first,
+                                       int last) {
+    if (types.empty() || !slabRange(volume.d, first, last))
+        return std::vector<Image>(types.size(), Image(0, 0, 1));
+
+    const int w = volume.w;
+    const int h = volume.h;
+
+    // Averages come straight from the slab index when there is one
+    const std::shared_ptr<const SlabIndex> index = volume.slabIndex();
+    const bool indexed = index && std::all_of(types.begin(), types.end(), [](ProjectionType type) {
+        return type == ProjectionType::Average;
+    });
+    if (indexed) {
+        Accumulator acc(types, static_cast<size_t>(w) * h);
+        index->sum(first, last, acc.sum.data());
+        return results(acc, types, w, h, last - first + 1);
+    }
+
+    Accumulator acc(types, static_cast<size_t>(w) * h);
+
+    // Each thread owns whole rows and sweeps them through the slab, so every
+    // read is a contiguous row and the accumulator rows stay in cache
+    #pragma omp parallel for schedule(dynamic, 8)
+    for (int y = 0; y < h; ++y) {
+        const size_t offset = static_cast<size_t>(y) * w;
+        for (int z = first; z <= last; ++z)
+            acc.fold(volume.slice(z) + offset, offset, w);
+    }
+
+    return results(acc, types, w, h, last - first + 1);
+}
+
+std::vector<uint32_t> Projection::projectSum(const Volume& volume, int first, int last) {
+    if (!slabRange(volume.d, first, last))
+        return {};
+
+    // The average's state is exactly the running sum
+    Accumulator acc({ProjectionType::Average}, static_cast<size_t>(volume.w) * volume.h);
+    if (const std::shared_ptr<const SlabIndex> index = volume.slabIndex()) {
+        index->sum(first, last, acc.sum.data());
+        return std::move(acc.sum);
+    }
+    #pragma omp parallel for schedule(dynamic, 8)
+    for (int y = 0; y < volume.h; ++y) {
+        const size_t offset = static_cast<size_t>(y) * volume.w;
+        for (int z = first; z <= last; ++z)
+            acc.fold(volume.slice(z) + offset, offset, volume.w);
+    }
+    return std::move(acc.sum);
+}
+
+void Projection::projectSliding(const Volume& volume, ProjectionType type, int thickness,
+                                const std::function<void(int, const Image&)>& sink) {
+    if (thickness < 1 || thickness > volume.d) {
+        std::cerr << "Slab thickness " << thickness << " does not fit the " << volume.d << " slices." << std::endl;
+        return;
+    }
+    if (type == ProjectionType::Maximum)
+        slidingExtremum(volume, thickness, [](unsigned char a, unsigned char b) { return std::max(a, b); }, sink);
+    else if (type == ProjectionType::Minimum)
+        slidingExtremum(volume, thickness, [](unsigned char a, unsigned char b) { return std::min(a, b); }, sink);
+    else
+        std::cerr << "Sliding projections are only available for the maximum and the minimum." << std::endl;
+}
+
+Image Projection::projectFiltered(const Volume& volume, ProjectionType type, const VolumeFilter& filter, int first,
+                                  int last) {
+    return projectFiltered(volume, std::vector<ProjectionType>{type}, filter, first, last)[0];
+}
+
+std::vector<Image> Projection::projectFiltered(const Volume& volume, const std::vector<ProjectionType>& types,
+                                               const VolumeFilter& filter, int first, int last) {
+    const std::vector<Image> failure(types.size(), Image(0, 0, 1));
+    if (types.empty() || !slabRange(volume.d, first, last))
+        return failure;
+
+    return foldFiltered(types, filter, volume.w, volume.h, volume.d, [&](int z) { return volume.slice(z); }, first,
+                        last);
+}
+
+Image Projection::project(const BrickedVolume& volume, ProjectionType type, int first, int last) {
+    return project(volume, std::vector<ProjectionType>{type}, first, last)[0];
+}
+
+std::vector<Image> Projection::project(const BrickedVolume& volume, const std::vector<ProjectionType>& types,
+                                       int first, int last) {
+    const std::vector<Image> failure(types.size(), Image(0, 0, 1));
+    if (!volume.good()) {
+        std::cerr << "The bricked volume cannot be read." << std::endl;
+        return failure;
+    }
+    if (types.empty() || !slabRange(volume.d, first, last))
+        return failure;
+
+    Accumulator acc(types, static_cast<size_t>(volume.w) * volume.h);
+    const auto source = volume.sliceSource();
+    for (int z = first; z <= last; ++z)
+        foldSlice(acc, source(z), volume.w, volume.h);
+    // Read errors have been reported by the volume
+    if (!volume.good())
+        return failure;
+
+    return results(acc, types, volume.w, volume.h, last - first + 1);
+}
+
+Image Projection::projectFiltered(const BrickedVolume& volume, ProjectionType type, const VolumeFilter& filter,
+                                  int first, int last) {
+    return projectFiltered(volume, std::vector<ProjectionType>{type}, filter, first, last)[0];
+}
+
+std::vector<Image> Projection::projectFiltered(const BrickedVolume& volume, const std::vector<ProjectionType>& types,
+                                               const VolumeFilter& filter, int first, int last) {
+    const std::vector<Image> failure(types.size(), Image(0, 0, 1));
+    if (!volume.good()) {
+        std::cerr << "The bricked volume cannot be read." << std::endl;
+        return failure;
+    }
+    if (types.empty() || !slabRange(volume.d, first, last))
+        return failure;
+
+    const std::vector<Image> images =
+        foldFiltered(types, filter, volume.w, volume.h, volume.d, volume.sliceSource(), first, last);
+    return volume.good() ? images : failure;
+}
+
+Image Projection::projectDirectory(const std::string& directory, ProjectionType type, int first, int last) {
+    return projectDirectory(directory, std::vector<ProjectionType>{type}, first, last)[0];
+}
+
+std::vector<Image> Projection::projectDirectory(const std::string& directory, const std::vector<ProjectionType>& types,
+                                                int first, int last) {
+    const std::vector<Image> failure(types.size(), Image(0, 0, 1));
+    const std::vector<std::string> files = Volume::listSlices(directory);
+    if (files.empty()) {
+        std::cerr << "No slice images in " << directory << std::endl;
+        return failure;
+    }
+    if (types.empty() || !slabRange(static_cast<int>(files.size()), first, last))
+        return failure;
+
+    int w, h, channels;
+    if (!stbi_info(files[first].c_str(), &w, &h, &channels)) {
+        std::cerr << "Cannot read " << files[first] << std::endl;
+        return failure;
+    }
+    const size_t n = static_cast<size_t>(w) * h;
+    Accumulator total(types, n);
+    bool failed = false;
+
+    // Threads fold the slices they decode into private accumulators, which
+    // are merged once at the end
+    #pragma omp parallel reduction(|| : failed)
+    {
+        Accumulator local(types, n);
+
+        #pragma omp for schedule(dynamic) nowait
+        for (int z = first; z <= last; ++z) {
+            const Volume::SlicePixels pixels = Volume::loadSlice(files[z], w, h);
+            if (pixels)
+                local.fold(pixels.get(), 0, n);
+            else
+                failed = true;
+        }
+
+        #pragma omp critical
+        total.merge(local);
+    }
+    if (failed)
+        return failure;
+
+    return results(total, types, w, h, last - first + 1);
+}
+
+Image Projection::projectDirectoryFiltered(const std::string& directory, ProjectionType type,
+                                           const VolumeFilter& filter, int first, int last) {
+    return projectDirectoryFiltered(directory, std::vector<ProjectionType>{type}, filter, first, last)[0];
+}
+
+std::vector<Image> Projection::projectDirectoryFiltered(const std::string& directory,
+                                                        const std::vector<ProjectionType>& types,
+                                                        const VolumeFilter& filter, int first, int last) {
+    const std::vector<Image> failure(types.size(), Image(0, 0, 1));
+    const std::vector<std::string> files = Volume::listSlices(directory);
+    if (files.empty()) {
+        std::cerr << "No slice images in " << directory << std::endl;
+        return failure;
+    }
+    const int d = static_cast<int>(files.size());
+    if (types.empty() || !slabRange(d, first, last))
+        return failure;
+
+    int w, h, channels;
+    if (!stbi_info(files[0].c_str(), &w, &h, &channels)) {
+        std::cerr << "Cannot read " << files[0] << std::endl;
+        return failure;
+    }
+    const size_t n = static_cast<size_t>(w) * h;
+
+    // The filter copies each slice into its window before asking for the
+    // next, so only the latest decoded slice is kept. A slice that fails
+    // stands in as black until the run ends and is reported as a failure.
+    Volume::SlicePixels pixels(nullptr, stbi_image_free);
+    const std::vector<unsigned char> blank(n, 0);
+    bool failed = false;
+    auto source = [&](int z) -> const unsigned char* {
+        pixels = Volume::loadSlice(files[z], w, h);
+        if (!pixels) {
+            failed = true;
+            return blank.data();
+        }
+        return pixels.get();
+    };
+
+    const std::vector<Image> images = foldFiltered(types, filter, w, h, d, source, first, last);
+    return failed ? failure : images;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "Image.h"
+#include "Volume.h"
+#include "BrickedVolume.h"
+#include "Filter3D.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Per pixel along z: the maximum (MIP), the mean (AIP, truncated like the
+// box blur), the minimum (MinIP) or the population standard deviation
+// (truncated). Raw sums do not fit a byte; see Projection::projectSum.
+enum class ProjectionType { Maximum, Average, Minimum, StandardDeviation };
+
+class Projection {
+public:
+    // Projection of slices [first, last] (inclusive, last = -1 for the final
+    // slice) of a loaded volume
+    Image project(const Volume& volume, ProjectionType type, int first = 0, int last = -1);
+    // Several projections of the same slab in one sweep over the voxels, one
+    // image per type in the order given
+    std::vector<Image> project(const Volume& volume, const std::vector<ProjectionType>& types, int first = 0,
+                               int last = -1);
+    // Per-pixel sums over the slab in 32 bits (w x h, row-major), from the
+    // slab index when the volume has one; empty if the slab is out of range
+    std::vector<uint32_t> projectSum(const Volume& volume, int first = 0, int last = -1);
+
+    // Maximum or minimum projections of every slab [z, z + thickness) of a
+    // loaded volume, z = 0 .. d - thickness, handed to sink(z, image) in
+    // order as soon as each is finished. Block prefix/suffix extremes (van
+    // Herk/Gil-Werman) make this three comparisons per voxel, whatever the
+    // thickness; only `thickness` + 1 planes are buffered.
+    void projectSliding(const Volume& volume, ProjectionType type, int thickness,
+                        const std::function<void(int, const Image&)>& sink);
+
+    // Projections of slab [first, last] of the volume after a 3D filter,
+    // without a filtered copy of it: filtered slices are produced one at a
+    // time from a ring of filter.size input slices and folded straight into
+    // the projection, so beyond the input only O(filter.size) slices are held
+    Image projectFiltered(const Volume& volume, ProjectionType type, const VolumeFilter& filter, int first = 0,
+                          int last = -1);
+    std::vector<Image> projectFiltered(const Volume& volume, const std::vector<ProjectionType>& types,
+                                       const VolumeFilter& filter, int first = 0, int last = -1);
+
+    // The same projections of a bricked volume, read slice by slice through
+    // its brick cache with the next slab of bricks prefetched
+    Image project(const BrickedVolume& volume, ProjectionType type, int first = 0, int last = -1);
+    std::vector<Image> project(const BrickedVolume& volume, const std::vector<ProjectionType>& types, int first = 0,
+                               int last = -1);
+    Image projectFiltered(const BrickedVolume& volume, ProjectionType type, const VolumeFilter& filter,
+                          int first = 0, int last = -1);
+    std::vector<Image> projectFiltered(const BrickedVolume& volume, const std::vector<ProjectionType>& types,
+                                       const VolumeFilter& filter, int first = 0, int last = -1);
+
+    // The same projection straight from a slice directory, without loading
+    // the volume: each slice is folded into the running result as soon as it
+    // is decoded, so memory stays at one slice and one accumulator per thread
+    Image projectDirectory(const std::string& directory, ProjectionType type, int first = 0, int last = -1);
+    std::vector<Image> projectDirectory(const std::string& directory, const std::vector<ProjectionType>& types,
+                                        int first = 0, int last = -1);
+    // Filtered projections straight from a slice directory, decoding each
+    // slice once as the filter window reaches it: peak memory is the ring of
+    // filter.size slices plus the accumulators, whatever the scan size
+    Image projectDirectoryFiltered(const std::string& directory, ProjectionType type, const VolumeFilter& filter,
+                                   int first = 0, int last = -1);
+    std::vector<Image> projectDirectoryFiltered(const std::string& directory, const std::vector<ProjectionType>& types,
+                                                const VolumeFilter& filter, int first = 0, int last = -1);
+};
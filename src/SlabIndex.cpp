@@ -0,0 +1,57 @@
+#include "SlabIndex.h"
+#include <algorithm>
+#include <vector>
+
+SlabIndex::SlabIndex(const unsigned char* voxels, int _w, int _h, int _d)
+    : w(_w), h(_h), d(_d), prefix(new uint32_t[static_cast<size_t>(_w) * _h * _d]) {
+    const size_t plane = static_cast<size_t>(w) * h;
+
+    // Each row of pixels runs down z on its own; a whole row is one
+    // vectorised add per slice
+    #pragma omp parallel for schedule(dynamic, 8)
+    for (int y = 0; y < h; ++y) {
+        const size_t offset = static_cast<size_t>(y) * w;
+        uint32_t* out = prefix.get() + offset;
+        const unsigned char* in = voxels + offset;
+        for (int x = 0; x < w; ++x)
+            out[x] = in[x];
+        for (int z = 1; z < d; ++z) {
+            const uint32_t* above = out;
+            out += plane;
+            in += plane;
+            #pragma omp simd
+            for (int x = 0; x < w; ++x)
+                out[x] = above[x] + in[x];
+        }
+    }
+}
+
+void SlabIndex::sum(int first, int last, uint32_t* out) const {
+    const long n = static_cast<long>(w) * h;
+    const uint32_t* upper = prefix.get() + static_cast<size_t>(last) * n;
+    if (first == 0) {
+        std::copy(upper, upper + n, out);
+        return;
+    }
+    const uint32_t* lower = prefix.get() + static_cast<size_t>(first - 1) * n;
+    #pragma omp parallel for simd
+    for (long i = 0; i < n; ++i)
+        out[i] = upper[i] - lower[i];
+}
+
+Image SlabIndex::average(int first, int last) const {
+    if (first < 0 || first > last || last >= d) {
+        std::cerr << "Slab [" << first << ", " << last << "] is outside the " << d << " slices." << std::endl;
+        return Image(0, 0, 1);
+    }
+    Image result(w, h, 1);
+    std::vector<uint32_t> sums(static_cast<size_t>(w) * h);
+    sum(first, last, sums.data());
+
+    const uint32_t count = static_cast<uint32_t>(last - first + 1);
+    unsigned char* out = result.data.get();
+    #pragma omp parallel for
+    for (long i = 0; i < static_cast<long>(sums.size()); ++i)
+        out[i] = static_cast<unsigned char>(sums[i] / count);
+    return result;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "Image.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Cumulative sums along z of a w x h x d volume: plane z holds, per pixel,
+// the sum of slices [0, z]. The sum or average over any slab [first, last]
+// is then one subtraction per pixel, whatever its thickness. 32-bit sums
+// are exact for up to 16 million slices.
+class SlabIndex {
+public:
+    // Volumes whose index fits this budget get one on load by default
+    static constexpr size_t DefaultBudget = size_t(1) << 30;
+
+    // Bytes the index of a w x h x d volume takes: four per voxel
+    static size_t memoryEstimate(int w, int h, int d) {
+        return static_cast<size_t>(w) * h * d * sizeof(uint32_t);
+    }
+
+    // Builds from a z-major voxel buffer, rows of pixels in parallel
+    SlabIndex(const unsigned char* voxels, int w, int h, int d);
+
+    int width() const { return w; }
+    int height() const { return h; }
+    int depth() const { return d; }
+
+    // Per-pixel sum over slices [first, last] (inclusive) into out (w x h)
+    void sum(int first, int last, uint32_t* out) const;
+    // Average intensity projection of [first, last], truncated like Projection
+    Image average(int first, int last) const;
+
+private:
+    int w;
+    int h;
+    int d;
+    // d planes of w * h, left uninitialised so the parallel build is the
+    // first touch of every page
+    std::unique_ptr<uint32_t[]> prefix;
+};
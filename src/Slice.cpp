@@ -0,0 +1,125 @@
+#include "Slice.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+Image Slice::extract(const Volume& volume, SlicePlane plane, int position) {
+    return extract(volume, std::vector<SlicePosition>{{plane, position}})[0];
+}
+
+std::vector<Image> Slice::extract(const Volume& volume, const std::vector<SlicePosition>& positions) {
+    const int w = volume.w;
+    const int h = volume.h;
+    const int d = volume.d;
+    std::vector<Image> images;
+    images.reserve(positions.size());
+
+    // Rows of slices to copy (xz) and columns to gather (yz), each with its
+    // output plane; columns sorted by x so a row is read front to back
+    struct Target { int position; unsigned char* out; };
+    std::vector<Target> rows;
+    std::vector<Target> columns;
+    for (const SlicePosition& request : positions) {
+        const int extent = request.plane == SlicePlane::XY ? d : request.plane == SlicePlane::XZ ? h : w;
+        if (request.position < 0 || request.position >= extent) {
+            std::cerr << "Plane position " << request.position << " is outside [0, " << extent << ")." << std::endl;
+            images.emplace_back(0, 0, 1);
+            continue;
+        }
+        switch (request.plane) {
+            case SlicePlane::XY:
+                images.push_back(volume.sliceImage(request.position));
+                break;
+            case SlicePlane::XZ:
+                images.emplace_back(w, d, 1);
+                rows.push_back({request.position, images.back().data.get()});
+                break;
+            case SlicePlane::YZ:
+                images.emplace_back(h, d, 1);
+                columns.push_back({request.position, images.back().data.get()});
+                break;
+        }
+    }
+    if (rows.empty() && columns.empty())
+        return images;
+    std::sort(columns.begin(), columns.end(), [](const Target& a, const Target& b) { return a.position < b.position; });
+
+    // Image row z of every xz and yz plane comes from slice z alone, so
+    // threads take whole slices and write disjoint rows. Several yz planes
+    // are gathered row by row, every requested column served from each row
+    // while it is in cache, so a cache line is fetched once per slice rather
+    // than once per plane; a single plane is a plain strided walk.
+    #pragma omp parallel for schedule(dynamic, 4)
+    for (int z = 0; z < d; ++z) {
+        const unsigned char* slice = volume.slice(z);
+        for (const Target& row : rows)
+            std::memcpy(row.out + static_cast<size_t>(z) * w, slice + static_cast<size_t>(row.position) * w, w);
+        if (columns.size() == 1) {
+            const unsigned char* src = slice + columns[0].position;
+            unsigned char* out = columns[0].out + static_cast<size_t>(z) * h;
+            for (int y = 0; y < h; ++y)
+                out[y] = src[static_cast<size_t>(y) * w];
+        } else if (!columns.empty()) {
+            for (int y = 0; y < h; ++y) {
+                const unsigned char* src = slice + static_cast<size_t>(y) * w;
+                const size_t index = static_cast<size_t>(z) * h + y;
+                for (const Target& column : columns)
+                    column.out[index] = src[column.position];
+            }
+        }
+    }
+    return images;
+}
+
+Image Slice::extract(const BrickedVolume& volume, SlicePlane plane, int position) {
+    return extract(volume, std::vector<SlicePosition>{{plane, position}})[0];
+}
+
+std::vector<Image> Slice::extract(const BrickedVolume& volume, const std::vector<SlicePosition>& positions) {
+    const int w = volume.w;
+    const int h = volume.h;
+    const int d = volume.d;
+    std::vector<Image> images(positions.size(), Image(0, 0, 1));
+    if (!volume.good()) {
+        std::cerr << "The bricked volume cannot be read." << std::endl;
+        return images;
+    }
+
+    // Same orientation and same brick column or slab means the same bricks
+    std::vector<size_t> order(positions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return std::make_pair(positions[a].plane, positions[a].position) <
+               std::make_pair(positions[b].plane, positions[b].position);
+    });
+
+    for (size_t i : order) {
+        const SlicePosition& request = positions[i];
+        const int extent = request.plane == SlicePlane::XY ? d : request.plane == SlicePlane::XZ ? h : w;
+        if (request.position < 0 || request.position >= extent) {
+            std::cerr << "Plane position " << request.position << " is outside [0, " << extent << ")." << std::endl;
+            continue;
+        }
+        const int p = request.position;
+        switch (request.plane) {
+            case SlicePlane::XY:
+                images[i] = Image(w, h, 1);
+                volume.readSlice(p, images[i].data.get());
+                break;
+            case SlicePlane::XZ:
+                // A box one voxel tall is laid out z-major, x fastest: w x d
+                images[i] = Image(w, d, 1);
+                volume.readBox(0, p, 0, w, p + 1, d, images[i].data.get());
+                break;
+            case SlicePlane::YZ:
+                // A box one voxel wide is laid out z-major, y fastest: h x d
+                images[i] = Image(h, d, 1);
+                volume.readBox(p, 0, 0, p + 1, h, d, images[i].data.get());
+                break;
+        }
+    }
+    // Read errors have been reported by the volume
+    if (!volume.good())
+        return std::vector<Image>(positions.size(), Image(0, 0, 1));
+    return images;
+}
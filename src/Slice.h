@@ -0,0 +1,34 @@
+#pragma once
+#include "Image.h"
+#include "Volume.h"
+#include "BrickedVolume.h"
+#include <vector>
+
+// Orientation of a plane through a volume, named by the two axes it spans:
+//   XY  slice z, w x h (the stored slices)
+//   XZ  row y of every slice, w x d: image row z is row y of slice z
+//   YZ  column x of every slice, h x d: image row z is column x of slice z
+enum class SlicePlane { XY, XZ, YZ };
+
+// A plane and its position along the third axis, e.g. {SlicePlane::XZ, 420}
+// for the xz plane at y = 420
+struct SlicePosition {
+    SlicePlane plane;
+    int position;
+};
+
+class Slice {
+public:
+    Image extract(const Volume& volume, SlicePlane plane, int position);
+    // Any number of planes in one sweep over the slices, one image per
+    // position in the order given; an out-of-range position gives an empty
+    // image. Every slice is visited once, whatever the number of planes, and
+    // each of its rows is read once for all yz planes.
+    std::vector<Image> extract(const Volume& volume, const std::vector<SlicePosition>& positions);
+
+    // The same planes of a bricked volume. A plane reads only the bricks it
+    // crosses, and planes crossing the same bricks are extracted one after
+    // another so they share the brick cache.
+    Image extract(const BrickedVolume& volume, SlicePlane plane, int position);
+    std::vector<Image> extract(const BrickedVolume& volume, const std::vector<SlicePosition>& positions);
+};
@@ -0,0 +1,143 @@
+#include "Volume.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+bool isSliceImage(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char ch) { return std::tolower(ch); });
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tga";
+}
+
+// Natural order: runs of digits compare by value, everything else by
+// character, ignoring case
+bool naturalLess(const std::string& a, const std::string& b) {
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (std::isdigit(static_cast<unsigned char>(a[i])) && std::isdigit(static_cast<unsigned char>(b[j]))) {
+            size_t i1 = i, j1 = j;
+            while (i1 < a.size() && std::isdigit(static_cast<unsigned char>(a[i1])))
+                ++i1;
+            while (j1 < b.size() && std::isdigit(static_cast<unsigned char>(b[j1])))
+                ++j1;
+            // Without leading zeros the longer run is the larger number
+            size_t zi = i, zj = j;
+            while (zi + 1 < i1 && a[zi] == '0')
+                ++zi;
+            while (zj + 1 < j1 && b[zj] == '0')
+                ++zj;
+            if (i1 - zi != j1 - zj)
+                return i1 - zi < j1 - zj;
+            const int order = a.compare(zi, i1 - zi, b, zj, j1 - zj);
+            if (order != 0)
+                return order < 0;
+            i = i1;
+            j = j1;
+            continue;
+        }
+        const int ca = std::tolower(static_cast<unsigned char>(a[i]));
+        const int cb = std::tolower(static_cast<unsigned char>(b[j]));
+        if (ca != cb)
+            return ca < cb;
+        ++i;
+        ++j;
+    }
+    if (a.size() - i != b.size() - j)
+        return a.size() - i < b.size() - j;
+    return a < b;
+}
+
+} // namespace
+
+Volume::Volume(const std::string& directory, size_t slabIndexBudget)
+    : size(0), w(0), h(0), d(0), index(std::make_shared<std::shared_ptr<const SlabIndex>>()) {
+    if (!Read(directory, slabIndexBudget))
+        std::cerr << "Failed to read volume " << directory << std::endl;
+}
+
+Volume::Volume(int _w, int _h, int _d)
+    : data(new unsigned char[static_cast<size_t>(_w) * _h * _d]), size(static_cast<size_t>(_w) * _h * _d),
+      w(_w), h(_h), d(_d), index(std::make_shared<std::shared_ptr<const SlabIndex>>()) {}
+
+std::vector<std::string> Volume::listSlices(const std::string& directory) {
+    std::vector<std::string> files;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+        if (entry.is_regular_file() && isSliceImage(entry.path()))
+            files.push_back(entry.path().string());
+    std::sort(files.begin(), files.end(), [](const std::string& a, const std::string& b) {
+        return naturalLess(std::filesystem::path(a).filename().string(), std::filesystem::path(b).filename().string());
+    });
+    return files;
+}
+
+Volume::SlicePixels Volume::loadSlice(const std::string& path, int expectedW, int expectedH) {
+    int sw, sh, sc;
+    SlicePixels pixels(stbi_load(path.c_str(), &sw, &sh, &sc, 1), stbi_image_free);
+    if (!pixels || sw != expectedW || sh != expectedH) {
+        #pragma omp critical
+        std::cerr << "Slice " << path << (pixels ? " does not match the first slice" : " cannot be read") << std::endl;
+        pixels.reset();
+    }
+    return pixels;
+}
+
+bool Volume::Read(const std::string& directory, size_t slabIndexBudget) {
+    const std::vector<std::string> files = listSlices(directory);
+    if (files.empty()) {
+        std::cerr << "No slice images in " << directory << std::endl;
+        return false;
+    }
+
+    // Every slice must match the first, so its header alone sizes the buffer
+    int width, height, channels;
+    if (!stbi_info(files[0].c_str(), &width, &height, &channels)) {
+        std::cerr << "Cannot read " << files[0] << std::endl;
+        return false;
+    }
+    const size_t sliceSize = static_cast<size_t>(width) * height;
+    std::shared_ptr<unsigned char[]> voxels(new unsigned char[sliceSize * files.size()]);
+
+    // Slices decode independently, each into its own z offset. stb_image
+    // always returns a buffer of its own, so that is the only copy made.
+    const long depth = static_cast<long>(files.size());
+    bool failed = false;
+    #pragma omp parallel for schedule(dynamic) reduction(|| : failed)
+    for (long z = 0; z < depth; ++z) {
+        const SlicePixels pixels = loadSlice(files[z], width, height);
+        if (pixels)
+            std::memcpy(voxels.get() + z * sliceSize, pixels.get(), sliceSize);
+        else
+            failed = true;
+    }
+    if (failed)
+        return false;
+
+    data = voxels;
+    w = width;
+    h = height;
+    d = static_cast<int>(depth);
+    size = sliceSize * depth;
+    // Copies still holding the previous buffer keep its index
+    index = std::make_shared<std::shared_ptr<const SlabIndex>>();
+    if (SlabIndex::memoryEstimate(w, h, d) <= slabIndexBudget)
+        buildSlabIndex();
+    return true;
+}
+
+void Volume::buildSlabIndex() {
+    *index = std::make_shared<const SlabIndex>(data.get(), w, h, d);
+}
+
+Image Volume::sliceImage(int z) const {
+    Image image(w, h, 1);
+    std::memcpy(image.data.get(), slice(z), static_cast<size_t>(w) * h);
+    return image;
+}
+
+void Volume::describe() const {
+    std::cout << "Volume with size " << w << " x " << h << " x " << d << "." << std::endl;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "Image.h"
+#include "SlabIndex.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// A stack of grayscale slices in one contiguous buffer, z-major: voxel
+// (x, y, z) is data[(z * h + y) * w + x], so each slice is a plain w x h
+// image at offset z * w * h.
+struct Volume
+{
+    std::shared_ptr<unsigned char[]> data;
+    size_t size;
+    int w;
+    int h;
+    int d;
+
+    // Constructors
+    Volume(const std::string& directory, size_t slabIndexBudget = SlabIndex::DefaultBudget);
+    Volume(int _w, int _h, int _d);
+
+    // Loads every slice image of a directory, in natural filename order. The
+    // slab index is built as part of the load when its memory estimate is
+    // within slabIndexBudget bytes; pass 0 to opt out.
+    bool Read(const std::string& directory, size_t slabIndexBudget = SlabIndex::DefaultBudget);
+    // z prefix sums for O(1) slab averages; null unless built. Copies of a
+    // volume share the index along with data, so code writing voxels through
+    // data or slice() must rebuild or drop it, which every copy then sees.
+    std::shared_ptr<const SlabIndex> slabIndex() const { return *index; }
+    // (Re)builds the slab index from the current voxels
+    void buildSlabIndex();
+    // Discards the slab index, for every copy
+    void dropSlabIndex() { index->reset(); }
+
+    unsigned char* slice(int z) const { return data.get() + static_cast<size_t>(z) * w * h; }
+    // Copy of slice z as a single-channel image
+    Image sliceImage(int z) const;
+
+    void describe() const;
+
+    // The slice images of a directory in natural order, so slice2.png comes
+    // before slice10.png; empty if the directory cannot be read
+    static std::vector<std::string> listSlices(const std::string& directory);
+    // One decoded slice, released with stbi_image_free
+    using SlicePixels = std::unique_ptr<unsigned char, void (*)(void*)>;
+    // Decodes the slice image at path as a single channel. Null, with an
+    // error, if it cannot be read or is not expectedW x expectedH like the
+    // first slice. Safe to call from parallel loops.
+    static SlicePixels loadSlice(const std::string& path, int expectedW, int expectedH);
+
+private:
+    // One slot per voxel buffer, shared by every copy that shares data
+    std::shared_ptr<std::shared_ptr<const SlabIndex>> index;
+};